@@ -92,7 +92,7 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sector (struct disk *, disk_sector_t, size_t);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -231,21 +231,7 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
-	struct channel *c;
-
-	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
-
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
-	lock_release (&c->lock);
+	disk_read_sectors (d, sec_no, &buffer, 1);
 }
 
 /* 버퍼(BUFFER)에 있는 DISK_SECTOR_SIZE 바이트를 디스크 D의 섹터 SEC_NO에 씁니다.
@@ -259,23 +245,68 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
    per-disk locking is unneeded. */
 void
 disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_sectors (d, sec_no, &buffer, 1);
+}
+
+/* 디스크 D의 SEC_NO부터 연속된 CNT개의 섹터를 한 번의 명령으로 읽습니다.
+   i번째 섹터는 BUFFERS[i]에 저장됩니다. 채널 락은 한 번만 잡습니다. */
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D
+   with a single READ SECTORS command.  Sector I is stored into
+   BUFFERS[I], which must have room for DISK_SECTOR_SIZE bytes.
+   CNT must be between 1 and DISK_MAX_SECTORS. */
+void
+disk_read_sectors (struct disk *d, disk_sector_t sec_no, void *buffers[], size_t cnt) {
+	struct channel *c;
+	size_t i;
+
+	ASSERT (d != NULL);
+	ASSERT (buffers != NULL);
+	ASSERT (cnt > 0 && cnt <= DISK_MAX_SECTORS);
+
+	c = d->channel;
+	lock_acquire (&c->lock);
+	select_sector (d, sec_no, cnt);
+	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
+	/* 섹터마다 인터럽트가 한 번씩 옵니다. */
+	for (i = 0; i < cnt; i++) {
+		sema_down (&c->completion_wait);
+		if (!wait_while_busy (d))
+			PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no + (disk_sector_t) i);
+		input_sector (c, buffers[i]);
+	}
+	d->read_cnt += cnt;
+	lock_release (&c->lock);
+}
+
+/* BUFFERS[0..CNT-1]을 디스크 D의 SEC_NO부터 연속된 섹터에 한 번의 명령으로 씁니다. */
+/* Writes BUFFERS[0] through BUFFERS[CNT - 1], DISK_SECTOR_SIZE
+   bytes each, to CNT consecutive sectors of disk D starting at
+   SEC_NO with a single WRITE SECTORS command.  Returns after the
+   disk has acknowledged the last sector.
+   CNT must be between 1 and DISK_MAX_SECTORS. */
+void
+disk_write_sectors (struct disk *d, disk_sector_t sec_no, const void *buffers[], size_t cnt) {
 	struct channel *c;
+	size_t i;
 
 	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+	ASSERT (buffers != NULL);
+	ASSERT (cnt > 0 && cnt <= DISK_MAX_SECTORS);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
+	select_sector (d, sec_no, cnt);
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	for (i = 0; i < cnt; i++) {
+		if (!wait_while_busy (d))
+			PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no + (disk_sector_t) i);
+		output_sector (c, buffers[i]);
+		sema_down (&c->completion_wait);
+	}
+	d->write_cnt += cnt;
 	lock_release (&c->lock);
 }
-
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
@@ -428,17 +459,19 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the sector count CNT to the disk's sector
+   selection registers.  (We use LBA mode.  A count of 256 is
+   written as 0.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
 	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt <= d->capacity - sec_no);
+	ASSERT (sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), (uint8_t) cnt);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -6,10 +6,17 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* Most full sectors inode_read_at() and inode_write_at() hand to the
+ * disk in one request. */
+#define BATCH_SECTORS 32
+
 /* On-disk inode.
  * Must be exactly DISK_SECTOR_SIZE bytes long. */
 struct inode_disk {
@@ -174,6 +181,10 @@ void
 inode_remove (struct inode *inode) {
 	ASSERT (inode != NULL);
 	inode->removed = true;
+#ifdef VM
+	/* Let go of read-ahead data, which holds the inode open. */
+	vm_readahead_forget (inode, 0, inode_length (inode));
+#endif
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
@@ -185,6 +196,11 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	off_t bytes_read = 0;
 	uint8_t *bounce = NULL;
 
+#ifdef VM
+	/* Do not read data older than a queued mmap writeback. */
+	vm_writeback_wait (inode);
+#endif
+
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -201,8 +217,20 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 			break;
 
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
+			/* Read full sectors directly into caller's buffer.  The
+			   sectors of a file are contiguous, so consecutive full
+			   sectors come in with a single request. */
+			void *sectors[BATCH_SECTORS];
+			size_t cnt = 0;
+
+			while (cnt < BATCH_SECTORS
+					&& (off_t) (cnt + 1) * DISK_SECTOR_SIZE <= size
+					&& (off_t) (cnt + 1) * DISK_SECTOR_SIZE <= inode_left) {
+				sectors[cnt] = buffer + bytes_read + cnt * DISK_SECTOR_SIZE;
+				cnt++;
+			}
+			disk_read_sectors (filesys_disk, sector_idx, sectors, cnt);
+			chunk_size = cnt * DISK_SECTOR_SIZE;
 		} else {
 			/* Read sector into bounce buffer, then partially copy
 			 * into caller's buffer. */
@@ -240,6 +268,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	if (inode->deny_write_cnt)
 		return 0;
 
+#ifdef VM
+	/* A queued mmap writeback must not land after this write. */
+	vm_writeback_wait (inode);
+#endif
+
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -256,8 +289,20 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 			break;
 
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
+			/* Write full sectors directly to disk.  The sectors of a
+			   file are contiguous, so consecutive full sectors go out
+			   in a single request. */
+			const void *sectors[BATCH_SECTORS];
+			size_t cnt = 0;
+
+			while (cnt < BATCH_SECTORS
+					&& (off_t) (cnt + 1) * DISK_SECTOR_SIZE <= size
+					&& (off_t) (cnt + 1) * DISK_SECTOR_SIZE <= inode_left) {
+				sectors[cnt] = buffer + bytes_written + cnt * DISK_SECTOR_SIZE;
+				cnt++;
+			}
+			disk_write_sectors (filesys_disk, sector_idx, sectors, cnt);
+			chunk_size = cnt * DISK_SECTOR_SIZE;
 		} else {
 			/* We need a bounce buffer. */
 			if (bounce == NULL) {
@@ -284,6 +329,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	}
 	free (bounce);
 
+#ifdef VM
+	/* Read-ahead copies of the written range are now stale. */
+	vm_readahead_forget (inode, offset - bytes_written, bytes_written);
+#endif
+
 	return bytes_written;
 }
 
@@ -0,0 +1,25 @@
+#ifndef __LIB_KERNEL_LZ_H
+#define __LIB_KERNEL_LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Small LZ77 codec for page-sized buffers.
+
+   The output is a sequence of tokens.  A token byte below 0x80
+   is followed by that many plus one literal bytes.  A token byte
+   of 0x80 or more copies (token & 0x7f) + LZ_MIN_MATCH bytes from
+   the 16-bit little-endian distance that follows it. */
+
+/* Number of entries in the work table passed to lz_compress(). */
+#define LZ_TABLE_SIZE 4096
+
+/* Largest input lz_compress() accepts. */
+#define LZ_MAX_INPUT 65535
+
+size_t lz_compress (const void *src, size_t src_len, void *dst, size_t dst_cap,
+                    uint16_t table[LZ_TABLE_SIZE]);
+bool lz_decompress (const void *src, size_t src_len, void *dst, size_t dst_len);
+
+#endif /* lib/kernel/lz.h */
@@ -36,6 +36,12 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Virtual memory extensions. */
+	SYS_MADVISE,                /* Advise the VM about a range of memory. */
+	SYS_MSYNC,                  /* Write back a range of a file mapping. */
+	SYS_MREMAP,                 /* Resize or move a file mapping. */
+	SYS_SETRSS,                 /* Limit the resident set of the process. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -13,6 +13,26 @@ typedef int pid_t;
 typedef int off_t;
 #define MAP_FAILED ((void *) NULL)
 
+/* OR into the WRITABLE argument of mmap() to read the whole mapping
+   and install its page table entries at map time.  mmap() fails if
+   some page cannot be loaded. */
+#define MAP_POPULATE 0x8
+
+/* Advice for madvise(). */
+#define MADV_NORMAL     0       /* No special treatment. */
+#define MADV_RANDOM     1       /* Expect random access: no readahead. */
+#define MADV_SEQUENTIAL 2       /* Expect sequential access. */
+#define MADV_WILLNEED   3       /* Will need these pages soon: read ahead. */
+#define MADV_DONTNEED   4       /* Don't need these pages any more. */
+
+/* Flags for msync(). Exactly one must be given. */
+#define MS_ASYNC        1       /* Queue the writes and return. */
+#define MS_SYNC         4       /* Return once the data is on disk. */
+
+/* Flag for mremap(): the mapping may be moved to another address if it
+   cannot be grown in place. */
+#define MREMAP_MAYMOVE  1
+
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
@@ -41,6 +61,10 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int madvise (void *addr, size_t length, int advice);
+int msync (void *addr, size_t length, int flags);
+void *mremap (void *addr, size_t old_size, size_t new_size, int flags);
+int setrss (size_t pages);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
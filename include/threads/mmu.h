@@ -2,23 +2,46 @@
 #define THREAD_MMU_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "threads/pte.h"
 
 typedef bool pte_for_each_func (uint64_t *pte, void *va, void *aux);
 
+/* Pages gathered by a TLB batch before it falls back to flushing the
+ * whole address space. */
+#define TLB_BATCH_PAGES 16
+
+/* TLB invalidations gathered between tlb_batch_begin() and
+ * tlb_batch_end().  Lives on the caller's stack. */
+struct tlb_batch {
+	uint64_t *pml4;                 /* 무효화를 모으는 주소 공간 */
+	size_t cnt;                     /* 모은 페이지 수, TLB_BATCH_PAGES 를 넘을 수 있음 */
+	uint64_t va[TLB_BATCH_PAGES];   /* 모은 주소 (처음 TLB_BATCH_PAGES 개) */
+	struct tlb_batch *prev;         /* 바깥쪽 batch */
+};
+
 uint64_t *pml4e_walk (uint64_t *pml4, const uint64_t va, int create);
+void pcid_init (void);
 uint64_t *pml4_create (void);
 bool pml4_for_each (uint64_t *, pte_for_each_func *, void *);
 void pml4_destroy (uint64_t *pml4);
 void pml4_activate (uint64_t *pml4);
 void *pml4_get_page (uint64_t *pml4, const void *upage);
 bool pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_is_huge (uint64_t *pml4, const void *upage);
+void pml4_clear_huge_pages (uint64_t *pml4);
 void pml4_clear_page (uint64_t *pml4, void *upage);
+bool pml4_move_page (uint64_t *pml4, void *from, void *to);
 bool pml4_is_dirty (uint64_t *pml4, const void *upage);
 void pml4_set_dirty (uint64_t *pml4, const void *upage, bool dirty);
 bool pml4_is_accessed (uint64_t *pml4, const void *upage);
 void pml4_set_accessed (uint64_t *pml4, const void *upage, bool accessed);
+void pml4_set_writable (uint64_t *pml4, const void *upage, bool writable);
+void tlb_batch_begin (struct tlb_batch *, uint64_t *pml4);
+void tlb_batch_end (struct tlb_batch *);
+void mmu_print_stats (void);
 
 #define is_writable(pte) (*(pte) & PTE_W)
 #define is_user_pte(pte) (*(pte) & PTE_U)
@@ -177,6 +177,7 @@ struct thread {
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4;                     /* 페이지 맵 레벨 4 *//* Page map level 4 */
+	struct tlb_batch *tlb_batch;        /* 모으는 중인 TLB 무효화, 없으면 NULL (mmu.c) */
 #endif
 #ifdef VM
 	/* 스레드가 소유한 전체 가상 메모리에 대한 테이블. */
@@ -4,11 +4,22 @@
 struct page;
 enum vm_type;
 
+/* 한 번에 함께 스왑 아웃하는 최대 페이지 수 */
+#define SWAP_CLUSTER_SIZE 8
+
 struct anon_page {
   int swap_idx;
+  bool readahead;   /* 스왑 readahead 로 미리 읽힌 뒤 아직 접근 여부를 기록하지 않음 */
+  bool dirtied;     /* 내용이 실행 파일과 달라진 적이 있음 (스왑에 쓰였거나, 공유되기 전이나
+                       copy-on-write 로 쓰임). 한 번 켜지면 꺼지지 않습니다. */
 };
 
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_swap_copy (struct page *page, void *kva);
+bool anon_swap_out_cluster (struct page *pages[], size_t cnt);
+void anon_print_stats (void);
+void anon_readahead_settle (struct page *page, bool accessed);
+bool anon_backed_by_file (struct page *page);
 
 #endif
@@ -0,0 +1,55 @@
+#ifndef VM_AREA_H
+#define VM_AREA_H
+#include <stddef.h>
+#include <list.h>
+#include "filesys/off_t.h"
+#include "vm/vm.h"
+
+struct page;
+struct file;
+struct supplemental_page_table;
+enum vm_type;
+
+/* 주소 공간의 한 영역 (VMA).
+ * 같은 파일, 같은 권한, 같은 타입을 갖는 연속된 페이지들을 한 번에 표현합니다.
+ * 영역 안의 struct page 는 처음 접근될 때 만들어집니다. */
+/* A region of the address space (VMA). Pages inside the region share the
+ * backing file, protection and type; their struct page is only created on
+ * first access. */
+struct vm_area {
+	void *start;            /* 첫 페이지 주소 (포함) */
+	void *end;              /* 마지막 페이지 다음 주소 (미포함) */
+	enum vm_type type;      /* 이 영역의 페이지 타입 */
+	bool writable;
+	struct file *file;      /* 내용을 읽어올 파일, 없으면 NULL. 영역이 소유합니다. */
+	off_t offset;           /* START 에 대응하는 파일 오프셋 */
+	size_t read_bytes;      /* START 부터 파일에서 읽을 바이트 수, 나머지는 0 */
+	struct list pages;      /* 이미 만들어진 페이지들 (page->area_elem) */
+	enum vm_advice advice;  /* madvise() 로 받은 접근 패턴 */
+};
+
+struct vm_area *vm_area_create (struct supplemental_page_table *spt,
+		void *start, size_t length, enum vm_type type, bool writable,
+		struct file *file, off_t offset, size_t read_bytes);
+void vm_area_destroy (struct supplemental_page_table *spt,
+		struct vm_area *area);
+struct vm_area *spt_find_area (struct supplemental_page_table *spt,
+		const void *va);
+bool spt_range_is_free (struct supplemental_page_table *spt,
+		const void *start, size_t length);
+bool spt_range_is_mapped (struct supplemental_page_table *spt,
+		const void *start, size_t length);
+void *spt_find_free_range (struct supplemental_page_table *spt,
+		const void *hint, size_t length);
+bool vm_area_resize (struct supplemental_page_table *spt,
+		struct vm_area *area, size_t length);
+bool vm_area_move (struct supplemental_page_table *spt,
+		struct vm_area *area, void *start);
+bool spt_copy_areas (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src);
+void spt_kill_areas (struct supplemental_page_table *spt);
+
+off_t vm_area_page_offset (struct vm_area *area, const void *upage);
+size_t vm_area_page_read_bytes (struct vm_area *area, const void *upage);
+
+#endif
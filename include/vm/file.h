@@ -4,15 +4,16 @@
 #include "vm/vm.h"
 
 struct page;
+struct inode;
 enum vm_type;
 
+/* vm_readahead() 가 한 번의 읽기로 묶는 최대 페이지 수 */
+#define VM_READAHEAD_BATCH 8
+
+/* 파일 자체는 page->area->file 에 있습니다. */
 struct file_page {
-	// bool dirty;
-	struct aux * aux;
-	struct file *file;
-	// size_t read_bytes;
-	// size_t zero_bytes;
-	// off_t ofs;
+	off_t ofs;          /* 이 페이지에 대응하는 파일 오프셋 */
+	size_t read_bytes;  /* 파일에서 읽고 쓸 바이트 수, 나머지는 0 */
 };
 
 void vm_file_init (void);
@@ -20,4 +21,11 @@ bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset);
 void do_munmap (void *va);
+void *do_mremap (void *addr, size_t old_size, size_t new_size, bool may_move);
+void file_print_stats (void);
+void file_backed_writeback (struct page *page);
+void vm_writeback_wait (struct inode *inode);
+void vm_readahead (struct file *file, off_t ofs, size_t bytes, bool sync);
+void vm_readahead_forget (struct inode *inode, off_t ofs, off_t size);
+off_t vm_file_read_page (struct file *file, void *kva, size_t bytes, off_t ofs);
 #endif
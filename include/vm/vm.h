@@ -2,6 +2,7 @@
 #define VM_VM_H
 #include <stdbool.h>
 #include "threads/palloc.h"
+#include "threads/vaddr.h"
 #include "lib/kernel/hash.h"
 
 enum vm_type {
@@ -33,9 +34,17 @@ enum vm_type {
 	VM_MARKER_END = (1 << 31),
 };
 
+/* madvise() 로 알려 준 영역의 접근 패턴 */
+enum vm_advice {
+	VM_ADVICE_NORMAL,       /* 기본 readahead / fault-around */
+	VM_ADVICE_RANDOM,       /* 주변 페이지를 미리 읽지 않음 */
+	VM_ADVICE_SEQUENTIAL,   /* 앞쪽을 더 많이 읽고, 지나간 페이지를 먼저 쫓아냄 */
+};
+
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
+#include "vm/area.h"
 #ifdef EFILESYS
 #include "filesys/page_cache.h"
 #endif
@@ -62,7 +71,11 @@ struct page {
 	bool writable ;
 	// enum vm_type full_type;
 	struct hash_elem spt_entry;
-	int page_cnt;
+	struct vm_area *area;        /* 이 페이지가 속한 영역, 스택 페이지는 NULL */
+	struct list_elem area_elem;  /* area->pages 의 원소 */
+	uint64_t *pml4;              /* 프레임에 매핑되어 있는 동안, 매핑한 주소 공간 */
+	struct supplemental_page_table *spt; /* 이 페이지가 들어 있는 spt */
+	struct list_elem rmap_elem;  /* frame->rmap 의 원소 */
 	/* 각 유형의 데이터가 union에 바인딩됩니다.
 	 * 각 함수는 현재 union을 자동으로 감지합니다. */
 	/* Per-type data are binded into the union.
@@ -79,12 +92,49 @@ struct page {
 
 /* "프레임"의 표현입니다. */
 /* The representation of "frame" */
+/* 역매핑(rmap): 프레임은 자신을 매핑한 모든 페이지를 rmap 에 갖고 있고,
+ * 각 페이지의 (pml4, va) 로 모든 매핑의 PTE 를 찾을 수 있습니다.
+ * rmap 과 ref_cnt 는 frame_lock 으로 보호됩니다.
+ * 프레임 서술자는 user pool 의 페이지마다 하나씩 frame_table 배열에 미리 만들어 두고,
+ * 배열 안의 위치가 곧 물리 페이지이므로 kva 를 따로 저장하지 않습니다 (frame_kva()).
+ * 시계 알고리즘이 훑는 필드를 앞에 모아 두었습니다. 비트 필드는 frame_lock 을 잡고만
+ * 바꿉니다. pinned 는 락 없이 풀기도 하므로 따로 둡니다. */
 struct frame {
-	void *kva;
-	struct page *page;
-	struct list_elem frame_elem;
+	struct list rmap;            /* 이 프레임을 매핑한 페이지들 (page->rmap_elem) */
+	uint16_t ref_cnt;            /* rmap 의 원소 수 (copy-on-write 로 공유하면 2 이상) */
+	bool pinned;                 /* true 이면 교체 대상에서 제외 */
+	bool used : 1;               /* user pool 에서 받아 VM 이 쓰고 있는 프레임 */
+	/* 매핑들의 accessed, dirty 비트 중 하나라도 켜져 있는 것을 본 적이 있으면 true.
+	 * 하드웨어는 비트를 켜기만 하고 끄는 것은 vm_frame_set_*() 뿐이므로, true 이면
+	 * 페이지 테이블을 다시 걷지 않아도 됩니다. false 는 "모름" 입니다. */
+	bool referenced : 1;
+	bool dirty : 1;
+	/* 같은 내용의 anon 프레임 합치기 (KSM). ksm_listed 이면 ksm_elem 으로 KSM 테이블에
+	 * 들어 있고, ksm_merged 이면 다른 프레임의 페이지들을 넘겨받은 프레임입니다. */
+	bool ksm_listed : 1;
+	bool ksm_merged : 1;
+	/* 여러 프로세스가 공유하는 실행 파일의 읽기 전용 페이지라면 그 위치.
+	 * text_inode 가 NULL 이 아니면 text_elem 으로 text 프레임 테이블에 들어 있습니다. */
+	struct inode *text_inode;
+	off_t text_ofs;
+	size_t text_read_bytes;      /* 파일에서 읽은 바이트 수, 나머지는 0 */
+	struct hash_elem text_elem;
+	uint64_t ksm_sum;            /* 지난번 검사 때 내용의 해시 */
+	struct hash_elem ksm_elem;
 };
 
+/* user pool 의 페이지마다 하나씩 있는 프레임 서술자 배열과 user pool 의 첫 페이지. */
+extern struct frame *frame_table;
+extern uint8_t *frame_base;
+
+/* FRAME 이 나타내는 user pool 페이지의 커널 가상 주소 */
+#define frame_kva(frame) \
+	((void *) (frame_base + (size_t) ((frame) - frame_table) * PGSIZE))
+
+/* FRAME 을 매핑한 첫 번째 페이지. 공유되지 않은 프레임에서는 유일한 페이지입니다. */
+#define frame_primary(frame) \
+	list_entry (list_front (&(frame)->rmap), struct page, rmap_elem)
+
 /* 페이지 작업에 대한 함수 테이블입니다.
  * 이것은 C에서 "인터페이스"를 구현하는 한 가지 방법입니다.
  * "메소드"의 테이블을 구조체의 멤버로 넣고,
@@ -111,8 +161,26 @@ struct page_operations {
 /* Representation of current process's memory space.
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this. */
+/* 최근에 찾은 페이지를 기억하는 조회 캐시의 크기 */
+#define SPT_CACHE_SIZE 8
+
+/* 스택이 자랄 수 있는 가장 낮은 주소 (최대 1MB) */
+#define STACK_LIMIT (USER_STACK - (1 << 20))
+
 struct supplemental_page_table {
 	struct hash spt_hash;
+	/* 시작 주소 순으로 정렬된 영역(VMA) 배열. vm/area.c 참고 */
+	struct vm_area **areas;
+	size_t area_cnt;
+	size_t area_cap;
+	/* 페이지 번호로 인덱싱하는 direct-mapped 조회 캐시.
+	 * 페이지를 spt 에서 뺄 때 함께 비워야 합니다. */
+	struct page *cache[SPT_CACHE_SIZE];
+	/* 프레임에 매핑된 페이지 수 (RSS) 와 그 상한. 상한이 0 이면 제한이 없고,
+	 * 상한에 닿은 프로세스는 자기 페이지를 내보내서 프레임을 얻습니다.
+	 * rss 는 frame_lock 으로 보호됩니다. */
+	size_t rss;
+	size_t rss_limit;
 };
 
 #include "threads/thread.h"
@@ -122,10 +190,29 @@ bool supplemental_page_table_copy (struct supplemental_page_table *dst,
 void supplemental_page_table_kill (struct supplemental_page_table *spt);
 struct page *spt_find_page (struct supplemental_page_table *spt,
 		void *va);
+struct page *spt_lookup_page (struct supplemental_page_table *spt,
+		void *va);
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
+bool spt_move_pages (struct supplemental_page_table *spt, struct list *pages,
+		ptrdiff_t delta);
+
+/* 페이지 아웃 데몬의 watermark (빈 user 프레임 수). 커널 명령줄에서 설정합니다. */
+extern size_t vm_pageout_low;
+extern size_t vm_pageout_high;
+/* 읽기 폴트 때 함께 올리는 창의 크기 (페이지 수). 커널 명령줄에서 설정합니다. */
+extern size_t vm_fault_around_pages;
+/* 압축 스왑 풀의 크기 (페이지 수), 0 이면 쓰지 않음. 커널 명령줄에서 설정합니다. */
+extern size_t vm_zswap_pages;
+/* KSM 스캐너가 한 번 깨어날 때 검사하는 프레임 수, 0 이면 끔. 커널 명령줄에서 설정합니다. */
+extern size_t vm_ksm_pages;
+/* 정렬된 2 MB anon 영역을 2 MB 페이지로 매핑할지. 커널 명령줄 -thp 로 켭니다. */
+extern bool vm_thp;
+/* 새 프로세스의 RSS 상한 (페이지 수), 0 이면 제한 없음. 커널 명령줄 -rss 로 설정합니다. */
+extern size_t vm_rss_limit;
 
 void vm_init (void); 
+void vm_print_stats (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
 
@@ -134,7 +221,25 @@ bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
+void vm_free_frame (struct page *page);
+bool vm_page_maps_zero (struct page *page);
+bool vm_advise (void *addr, size_t length, enum vm_advice advice);
+bool vm_willneed (void *addr, size_t length);
+bool vm_dontneed (void *addr, size_t length);
+bool vm_populate (void *addr, size_t length);
+bool vm_msync (void *addr, size_t length, bool sync);
+bool vm_set_rss_limit (size_t pages);
+struct frame *vm_get_free_frame (void);
+struct frame *vm_frame_of (const void *kva);
+void vm_map_frame (struct frame *frame, struct page *page, uint64_t *pml4);
+void vm_frame_unmap_all (struct frame *frame);
+void vm_frame_remap_all (struct frame *frame);
+bool vm_frame_is_accessed (struct frame *frame);
+bool vm_frame_is_dirty (struct frame *frame);
+void vm_frame_set_accessed (struct frame *frame, bool accessed);
+void vm_frame_set_dirty (struct frame *frame, bool dirty);
 bool vm_claim_page (void *va);
+bool vm_prepare_write (void *va);
 enum vm_type page_get_type (struct page *page);
 
 unsigned page_hash(struct hash_elem *p_, void *aux UNUSED);
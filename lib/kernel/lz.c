@@ -0,0 +1,121 @@
+#include "lz.h"
+#include <debug.h>
+#include <string.h>
+
+/* Shortest and longest match a single token can describe. */
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_MATCH (0x7f + LZ_MIN_MATCH)
+
+/* Longest literal run a single token can describe. */
+#define LZ_MAX_LITERALS 0x80
+
+/* Hashes the LZ_MIN_MATCH bytes at P into the work table. */
+static inline size_t
+hash4 (const uint8_t *p) {
+	uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+	return (v * 2654435761u) >> 20;
+}
+
+/* Appends the CNT literal bytes at SRC to DST, whose OUT bytes
+   out of CAP are in use.  Returns false if they do not fit. */
+static bool
+emit_literals (const uint8_t *src, size_t cnt, uint8_t *dst, size_t *out,
+		size_t cap) {
+	while (cnt > 0) {
+		size_t run = cnt < LZ_MAX_LITERALS ? cnt : LZ_MAX_LITERALS;
+
+		if (*out + 1 + run > cap)
+			return false;
+		dst[(*out)++] = run - 1;
+		memcpy (dst + *out, src, run);
+		*out += run;
+		src += run;
+		cnt -= run;
+	}
+	return true;
+}
+
+/* Compresses the SRC_LEN bytes at SRC into DST, which has room
+   for DST_CAP bytes, using TABLE as scratch space.  Returns the
+   compressed size, or 0 if the result would not fit in DST_CAP
+   bytes. */
+size_t
+lz_compress (const void *src_, size_t src_len, void *dst_, size_t dst_cap,
+		uint16_t table[LZ_TABLE_SIZE]) {
+	const uint8_t *src = src_;
+	uint8_t *dst = dst_;
+	size_t in = 0, out = 0, lit = 0;
+
+	ASSERT (src_len <= LZ_MAX_INPUT);
+
+	/* Table entries hold a position plus one; zero means empty. */
+	memset (table, 0, LZ_TABLE_SIZE * sizeof *table);
+	while (in + LZ_MIN_MATCH <= src_len) {
+		size_t h = hash4 (src + in);
+		size_t cand = table[h];
+
+		table[h] = in + 1;
+		if (cand == 0 || memcmp (src + cand - 1, src + in, LZ_MIN_MATCH)) {
+			in++;
+			continue;
+		}
+		cand--;
+
+		size_t len = LZ_MIN_MATCH;
+		while (in + len < src_len && len < LZ_MAX_MATCH
+				&& src[cand + len] == src[in + len])
+			len++;
+
+		size_t dist = in - cand;
+		if (!emit_literals (src + lit, in - lit, dst, &out, dst_cap)
+				|| out + 3 > dst_cap)
+			return 0;
+		dst[out++] = 0x80 | (len - LZ_MIN_MATCH);
+		dst[out++] = dist & 0xff;
+		dst[out++] = dist >> 8;
+		in += len;
+		lit = in;
+	}
+	if (!emit_literals (src + lit, src_len - lit, dst, &out, dst_cap))
+		return 0;
+	return out;
+}
+
+/* Decompresses the SRC_LEN bytes at SRC, produced by
+   lz_compress(), into the DST_LEN bytes at DST.  Returns true if
+   the input was well formed and expanded to exactly DST_LEN
+   bytes. */
+bool
+lz_decompress (const void *src_, size_t src_len, void *dst_, size_t dst_len) {
+	const uint8_t *src = src_;
+	uint8_t *dst = dst_;
+	size_t in = 0, out = 0;
+
+	while (in < src_len) {
+		uint8_t token = src[in++];
+
+		if (token < 0x80) {
+			size_t run = token + 1;
+
+			if (in + run > src_len || out + run > dst_len)
+				return false;
+			memcpy (dst + out, src + in, run);
+			in += run;
+			out += run;
+		} else {
+			size_t len = (token & 0x7f) + LZ_MIN_MATCH;
+
+			if (in + 2 > src_len)
+				return false;
+			size_t dist = src[in] | (src[in + 1] << 8);
+			in += 2;
+			if (dist == 0 || dist > out || out + len > dst_len)
+				return false;
+
+			/* The source may overlap the bytes being written. */
+			for (size_t i = 0; i < len; i++, out++)
+				dst[out] = dst[out - dist];
+		}
+	}
+	return out == dst_len;
+}
@@ -54,7 +54,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -155,6 +155,26 @@ munmap (void *addr) {
 	syscall1 (SYS_MUNMAP, addr);
 }
 
+int
+madvise (void *addr, size_t length, int advice) {
+	return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+int
+msync (void *addr, size_t length, int flags) {
+	return syscall3 (SYS_MSYNC, addr, length, flags);
+}
+
+void *
+mremap (void *addr, size_t old_size, size_t new_size, int flags) {
+	return (void *) syscall4 (SYS_MREMAP, addr, old_size, new_size, flags);
+}
+
+int
+setrss (size_t pages) {
+	return syscall1 (SYS_SETRSS, pages);
+}
+
 bool
 chdir (const char *dir) {
 	return syscall1 (SYS_CHDIR, dir);
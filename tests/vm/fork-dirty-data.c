@@ -0,0 +1,70 @@
+/* Writes the initialized data segment, forks, and then overwrites it in
+   the parent, so that the child's frames are no longer mapped by the
+   page that dirtied them.  The child then squeezes its own resident set
+   until those frames are evicted and checks that it reads back what the
+   parent wrote before the fork, not the bytes of the executable. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE 4096
+#define DATA_PAGES 8
+#define CHURN_PAGES 64
+
+/* Initialized, so it lives in the data segment read from the file. */
+static char data[DATA_PAGES * PAGE] = { 1 };
+static char churn[CHURN_PAGES * PAGE];
+
+static void
+fill (char base)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof data; i += PAGE / 4)
+    data[i] = base + i / PAGE;
+}
+
+static void
+check (const char *who, char base)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof data; i += PAGE / 4)
+    if (data[i] != (char) (base + i / PAGE))
+      fail ("%s: data page %zu has %d (should be %d)", who, i / PAGE,
+            data[i], (char) (base + i / PAGE));
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+  int fd;
+
+  fill ('A');
+  child = fork ("child");
+  if (child == 0)
+    {
+      /* Wait until the parent has copied its pages away. */
+      while ((fd = open ("go")) < 0)
+        continue;
+      close (fd);
+
+      if (setrss (16) != 0)
+        fail ("setrss 16");
+      for (i = 0; i < sizeof churn; i += PAGE)
+        churn[i] = i / PAGE;
+      check ("child", 'A');
+      exit (0);
+    }
+  CHECK (child > 0, "fork");
+
+  /* Copy-on-write: the parent's dirty PTEs now point at new frames. */
+  fill ('a');
+  CHECK (create ("go", 0), "create \"go\"");
+  CHECK (wait (child) == 0, "wait for child");
+  check ("parent", 'a');
+}
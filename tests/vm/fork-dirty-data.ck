@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fork-dirty-data) begin
+(fork-dirty-data) fork
+(fork-dirty-data) create "go"
+(fork-dirty-data) wait for child
+(fork-dirty-data) end
+EOF
+pass;
@@ -0,0 +1,57 @@
+/* Touches a 4 MB, 2 MB aligned array one page at a time with the kernel
+   running with -thp, so that each 2 MB block can be filled by a single
+   fault and mapped with one page directory entry.  A forked child then
+   writes into part of the array, which splits the shared 2 MB mappings
+   back into 4 kB pages for copy-on-write, and the parent checks that its
+   own copy is unchanged.  Compare the "VM:" and "MMU:" statistics printed
+   at power off with those of page-linear to see the saved faults and
+   page-table pages. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (4 * 1024 * 1024)
+#define PAGE 4096
+
+static char buf[SIZE] __attribute__ ((aligned (2 * 1024 * 1024)));
+
+static void
+check (const char *who, int bias)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i += PAGE)
+    if (buf[i] != (char) (i / PAGE + bias) || buf[i + PAGE - 1] != 0)
+      fail ("%s: page %zu has wrong contents", who, i / PAGE);
+}
+
+void
+test_main (void)
+{
+  size_t i;
+  pid_t child;
+
+  msg ("initialize");
+  for (i = 0; i < SIZE; i += PAGE)
+    buf[i] = i / PAGE;
+  check ("parent", 0);
+
+  msg ("fork");
+  child = fork ("child");
+  if (child == 0)
+    {
+      /* Every write hits a read-only shared page and copies it. */
+      for (i = SIZE / 4; i < SIZE * 3 / 4; i += PAGE)
+        buf[i]++;
+      for (i = SIZE / 4; i < SIZE * 3 / 4; i += PAGE)
+        if (buf[i] != (char) (i / PAGE + 1))
+          fail ("child: page %zu has wrong contents", i / PAGE);
+      exit (0);
+    }
+  CHECK (child > 0, "fork succeeded");
+  CHECK (wait (child) == 0, "wait for child");
+  check ("parent after fork", 0);
+  msg ("read pass");
+}
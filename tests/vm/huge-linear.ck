@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(huge-linear) begin
+(huge-linear) initialize
+(huge-linear) fork
+(huge-linear) fork succeeded
+(huge-linear) wait for child
+(huge-linear) read pass
+(huge-linear) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Asks for a file mapping to be read ahead with MADV_WILLNEED, then
+   changes part of the file with write() before touching the mapping,
+   and checks that the mapping shows the new data rather than what was
+   read ahead. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define FILE_PAGES 8
+#define CHANGED_PAGE 3
+
+static char page[PAGE_SIZE];
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  int handle;
+  size_t i;
+
+  CHECK (create ("data", FILE_PAGES * PAGE_SIZE), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  memset (page, 'a', sizeof page);
+  for (i = 0; i < FILE_PAGES; i++)
+    if (write (handle, page, sizeof page) != sizeof page)
+      fail ("write of page %zu failed", i);
+
+  CHECK (mmap (actual, FILE_PAGES * PAGE_SIZE, 0, handle, 0) != MAP_FAILED,
+         "mmap \"data\"");
+  CHECK (madvise (actual, FILE_PAGES * PAGE_SIZE, MADV_WILLNEED) == 0,
+         "madvise willneed");
+
+  memset (page, 'b', sizeof page);
+  seek (handle, CHANGED_PAGE * PAGE_SIZE);
+  CHECK (write (handle, page, sizeof page) == sizeof page,
+         "overwrite page %d", CHANGED_PAGE);
+
+  for (i = 0; i < FILE_PAGES * PAGE_SIZE; i++)
+    {
+      char expected = i / PAGE_SIZE == CHANGED_PAGE ? 'b' : 'a';
+      if (actual[i] != expected)
+        fail ("byte %zu of mapping has value %02hhx (should be %02hhx)",
+              i, actual[i], expected);
+    }
+
+  munmap (actual);
+  close (handle);
+}
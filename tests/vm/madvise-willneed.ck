@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-willneed) begin
+(madvise-willneed) create "data"
+(madvise-willneed) open "data"
+(madvise-willneed) mmap "data"
+(madvise-willneed) madvise willneed
+(madvise-willneed) overwrite page 3
+(madvise-willneed) end
+EOF
+pass;
@@ -0,0 +1,46 @@
+/* Gives the VM access-pattern hints with madvise() on a file mapping and
+   on the bss, and checks that MADV_DONTNEED drops anonymous data. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define BUF_PAGES 4
+
+static char buf[BUF_PAGES * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  int handle;
+  size_t i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (actual, 4096, 0, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+  CHECK (madvise (actual, 4096, MADV_SEQUENTIAL) == 0, "madvise sequential");
+  CHECK (madvise (actual, 4096, MADV_WILLNEED) == 0, "madvise willneed");
+  if (memcmp (actual, sample, strlen (sample)))
+    fail ("read of mmap'd file reported bad data");
+
+  /* Dropped anonymous pages come back zeroed. */
+  memset (buf, 'a', sizeof buf);
+  CHECK (madvise (buf, sizeof buf, MADV_DONTNEED) == 0, "madvise dontneed");
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != 0)
+      fail ("byte %zu of dropped page has value %02hhx (should be 0)",
+            i, buf[i]);
+
+  CHECK (madvise (buf, sizeof buf, MADV_RANDOM) == 0, "madvise random");
+  CHECK (madvise ((void *) 0x20000000, 4096, MADV_WILLNEED) == -1,
+         "madvise on unmapped memory must fail");
+  CHECK (madvise (actual + 1, 4096, MADV_NORMAL) == -1,
+         "madvise on misaligned address must fail");
+  CHECK (madvise (actual, 4096, 42) == -1, "madvise with bad advice must fail");
+
+  munmap (actual);
+  close (handle);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise) begin
+(madvise) open "sample.txt"
+(madvise) mmap "sample.txt"
+(madvise) madvise sequential
+(madvise) madvise willneed
+(madvise) madvise dontneed
+(madvise) madvise random
+(madvise) madvise on unmapped memory must fail
+(madvise) madvise on misaligned address must fail
+(madvise) madvise with bad advice must fail
+(madvise) end
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Maps part of a file, several read batches long, with MAP_POPULATE
+   and checks that every page is resident before it is first touched. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/large.inc"
+
+#define PAGE_SIZE 4096
+#define MAP_PAGES 20
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  int handle;
+  size_t i;
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  CHECK (mmap (actual, MAP_PAGES * PAGE_SIZE, MAP_POPULATE, handle, 0) != MAP_FAILED,
+         "mmap \"large.txt\" with MAP_POPULATE");
+
+  for (i = 0; i < MAP_PAGES; i++)
+    if (get_phys_addr (actual + i * PAGE_SIZE) == 0)
+      fail ("page %zu of populated mapping is not loaded", i);
+  msg ("all pages loaded");
+
+  if (memcmp (actual, large, MAP_PAGES * PAGE_SIZE))
+    fail ("read of populated mapping reported bad data");
+
+  munmap (actual);
+  close (handle);
+}
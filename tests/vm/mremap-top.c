@@ -0,0 +1,45 @@
+/* Maps two pages right below the kernel and checks that mremap() can
+   neither grow the lower one in place past the upper one nor move it
+   into kernel space, and that absurd sizes are refused. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define TOP ((char *) 0x8004000000)
+
+void
+test_main (void)
+{
+  char *lower = TOP - 0x2000;
+  char *upper = TOP - 0x1000;
+  int handle, handle2;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((handle2 = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  CHECK (mmap (lower, 4096, 0, handle, 0) != MAP_FAILED,
+         "mmap two pages below the kernel");
+  CHECK (mmap (upper, 4096, 0, handle2, 0) != MAP_FAILED,
+         "mmap the last user page");
+  if (memcmp (lower, sample, strlen (sample)))
+    fail ("lower mapping has bad data");
+
+  /* There is no room above the upper mapping and no free range at or
+     above the lower one, so both must fail instead of reaching the
+     kernel. */
+  CHECK (mremap (upper, 4096, 8192, 0) == MAP_FAILED,
+         "mremap into the kernel must fail");
+  CHECK (mremap (lower, 4096, 8192, MREMAP_MAYMOVE) == MAP_FAILED,
+         "mremap move into the kernel must fail");
+  CHECK (mremap (lower, 4096, (size_t) -1, MREMAP_MAYMOVE) == MAP_FAILED,
+         "mremap to an overflowing size must fail");
+  if (memcmp (lower, sample, strlen (sample)))
+    fail ("lower mapping changed");
+
+  munmap (upper);
+  munmap (lower);
+  close (handle2);
+  close (handle);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mremap-top) begin
+(mremap-top) open "sample.txt"
+(mremap-top) open "sample.txt" again
+(mremap-top) mmap two pages below the kernel
+(mremap-top) mmap the last user page
+(mremap-top) mremap into the kernel must fail
+(mremap-top) mremap move into the kernel must fail
+(mremap-top) mremap to an overflowing size must fail
+(mremap-top) end
+EOF
+pass;
@@ -0,0 +1,60 @@
+/* Grows a file mapping in place with mremap(), then forces it to move and
+   checks that the contents, including unsaved changes, follow it and that
+   the changes still reach the file. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+#define BLOCKER ((char *) 0x10004000)
+
+void
+test_main (void)
+{
+  static char buf[4096];
+  char *actual = ACTUAL;
+  char *moved;
+  int handle, handle2;
+  size_t i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (actual, 4096, 1, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+  actual[0] = 'M';
+
+  /* Nothing follows the mapping, so it grows where it is. */
+  CHECK (mremap (actual, 4096, 8192, 0) == actual, "mremap grow in place");
+  if (actual[0] != 'M' || memcmp (actual + 1, sample + 1, strlen (sample) - 1))
+    fail ("mapping changed while growing in place");
+  for (i = 4096; i < 8192; i++)
+    if (actual[i] != 0)
+      fail ("byte %zu past end of file has value %02hhx (should be 0)",
+            i, actual[i]);
+
+  /* Another mapping right after it blocks growing in place. */
+  CHECK ((handle2 = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  CHECK (mmap (BLOCKER, 4096, 0, handle2, 0) != MAP_FAILED,
+         "mmap \"sample.txt\" after the first mapping");
+  CHECK (mremap (actual, 8192, 32768, 0) == MAP_FAILED,
+         "mremap without MREMAP_MAYMOVE must fail");
+  moved = mremap (actual, 8192, 32768, MREMAP_MAYMOVE);
+  CHECK (moved != MAP_FAILED && moved != actual, "mremap move");
+  if (moved[0] != 'M' || memcmp (moved + 1, sample + 1, strlen (sample) - 1))
+    fail ("moved mapping has bad data");
+
+  CHECK (mremap (moved, 32768, 4096, 0) == moved, "mremap shrink");
+  CHECK (mremap ((void *) 0x20000000, 4096, 8192, MREMAP_MAYMOVE) == MAP_FAILED,
+         "mremap of unmapped memory must fail");
+
+  /* The change made before the move is written back on munmap. */
+  munmap (moved);
+  CHECK (read (handle2, buf, 1) == 1, "read first byte");
+  if (buf[0] != 'M')
+    fail ("file has '%c' at offset 0 (should be 'M')", buf[0]);
+
+  munmap (BLOCKER);
+  close (handle2);
+  close (handle);
+}
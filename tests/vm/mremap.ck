@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mremap) begin
+(mremap) open "sample.txt"
+(mremap) mmap "sample.txt"
+(mremap) mremap grow in place
+(mremap) open "sample.txt" again
+(mremap) mmap "sample.txt" after the first mapping
+(mremap) mremap without MREMAP_MAYMOVE must fail
+(mremap) mremap move
+(mremap) mremap shrink
+(mremap) mremap of unmapped memory must fail
+(mremap) read first byte
+(mremap) end
+EOF
+pass;
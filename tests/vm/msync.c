@@ -0,0 +1,51 @@
+/* Modifies a writable file mapping, flushes it with msync() and checks
+   through a separate file descriptor that the file was updated while the
+   mapping stays usable. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+void
+test_main (void)
+{
+  static const char overwrite[] = "msync wrote this line.\n";
+  static char buf[4096];
+  char *actual = ACTUAL;
+  int handle, handle2;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (actual, 4096, 1, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+  memcpy (actual, overwrite, strlen (overwrite));
+
+  CHECK (msync (actual, 4096, MS_SYNC) == 0, "msync sync");
+  CHECK ((handle2 = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  CHECK (read (handle2, buf, strlen (sample)) == (int) strlen (sample),
+         "read \"sample.txt\"");
+  if (memcmp (buf, overwrite, strlen (overwrite)))
+    fail ("msync'd data not found in file");
+  if (memcmp (buf + strlen (overwrite), sample + strlen (overwrite),
+              strlen (sample) - strlen (overwrite)))
+    fail ("msync changed unmodified part of file");
+
+  /* The mapping is still there and can be written and flushed again. */
+  actual[0] = 'M';
+  CHECK (msync (actual, 4096, MS_ASYNC) == 0, "msync async");
+  seek (handle2, 0);
+  CHECK (read (handle2, buf, 1) == 1, "read first byte");
+  if (buf[0] != 'M')
+    fail ("file has '%c' at offset 0 (should be 'M')", buf[0]);
+
+  CHECK (msync ((void *) 0x20000000, 4096, MS_SYNC) == -1,
+         "msync on unmapped memory must fail");
+  CHECK (msync (actual, 4096, MS_SYNC | MS_ASYNC) == -1,
+         "msync with bad flags must fail");
+
+  munmap (actual);
+  close (handle2);
+  close (handle);
+}
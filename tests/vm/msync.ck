@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(msync) begin
+(msync) open "sample.txt"
+(msync) mmap "sample.txt"
+(msync) msync sync
+(msync) open "sample.txt" again
+(msync) read "sample.txt"
+(msync) msync async
+(msync) read first byte
+(msync) msync on unmapped memory must fail
+(msync) msync with bad flags must fail
+(msync) end
+EOF
+pass;
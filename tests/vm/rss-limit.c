@@ -0,0 +1,49 @@
+/* Limits the resident set with setrss(), then writes and verifies an
+   array four times larger than the limit, so that the process has to
+   reclaim its own pages.  A forked child inherits the limit and does
+   the same. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LIMIT 64
+#define PAGE 4096
+#define SIZE (LIMIT * 4 * PAGE)
+
+static char buf[SIZE];
+
+static void
+churn (const char *who, int bias)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i += PAGE)
+    buf[i] = i / PAGE + bias;
+  for (i = 0; i < SIZE; i += PAGE)
+    if (buf[i] != (char) (i / PAGE + bias))
+      fail ("%s: page %zu has wrong contents", who, i / PAGE);
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+
+  CHECK (setrss (1) == -1, "setrss below the minimum fails");
+  CHECK (setrss (LIMIT) == 0, "setrss %d", LIMIT);
+  churn ("parent", 0);
+  msg ("parent pass");
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      churn ("child", 1);
+      exit (0);
+    }
+  CHECK (child > 0, "fork succeeded");
+  CHECK (wait (child) == 0, "wait for child");
+  churn ("parent", 2);
+  msg ("parent pass after fork");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(rss-limit) begin
+(rss-limit) setrss below the minimum fails
+(rss-limit) setrss 64
+(rss-limit) parent pass
+(rss-limit) fork succeeded
+(rss-limit) wait for child
+(rss-limit) parent pass after fork
+(rss-limit) end
+EOF
+pass;
@@ -0,0 +1,62 @@
+/* Keeps a small working set in the parent while a forked child that
+   limits itself with setrss() writes an array larger than physical
+   memory.  The child has to reclaim its own pages, so the parent's
+   working set should still be resident when it reads it back.  Compare
+   the "VM:" evictions and the swap disk's reads at power off with a
+   run in which the child sets no limit. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE 4096
+#define WORKING_PAGES 128
+#define LIMIT 64
+#define HOG_PAGES 2048
+
+static char working[WORKING_PAGES * PAGE];
+static char hog[HOG_PAGES * PAGE];
+
+static void
+touch (char *buf, size_t pages, int bias)
+{
+  size_t i;
+
+  for (i = 0; i < pages; i++)
+    buf[i * PAGE] = i + bias;
+}
+
+static bool
+verify (const char *buf, size_t pages, int bias)
+{
+  size_t i;
+
+  for (i = 0; i < pages; i++)
+    if (buf[i * PAGE] != (char) (i + bias))
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+
+  touch (working, WORKING_PAGES, 0);
+  msg ("parent touched its working set");
+
+  child = fork ("hog");
+  if (child == 0)
+    {
+      if (setrss (LIMIT) != 0)
+        fail ("hog: setrss %d", LIMIT);
+      touch (hog, HOG_PAGES, 1);
+      if (!verify (hog, HOG_PAGES, 1))
+        fail ("hog: array has wrong contents");
+      exit (0);
+    }
+  CHECK (child > 0, "fork succeeded");
+  CHECK (wait (child) == 0, "wait for hog");
+  CHECK (verify (working, WORKING_PAGES, 0), "parent working set intact");
+}
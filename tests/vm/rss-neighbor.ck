@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(rss-neighbor) begin
+(rss-neighbor) parent touched its working set
+(rss-neighbor) fork succeeded
+(rss-neighbor) wait for hog
+(rss-neighbor) parent working set intact
+(rss-neighbor) end
+EOF
+pass;
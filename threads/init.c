@@ -188,6 +188,7 @@ static void paging_init(uint64_t mem_end) {
     // CR3 레지스터를 새로운 페이지 테이블 주소로 업데이트합니다.
     // reload cr3
     pml4_activate(0);
+    pcid_init(); // 지원하면 문맥 전환 때 TLB 를 비우지 않도록 PCID 를 켠다
 }
 
 /* 커널 커맨드 라인을 단어로 분리하여 argv 형식의 배열로 반환합니다. */
@@ -251,6 +252,22 @@ static char **parse_options(char **argv) {
             user_page_limit = atoi(value);
         else if (!strcmp(name, "-threads-tests"))  // 스레드 테스트 실행 옵션
             thread_tests = true;
+#endif
+#ifdef VM
+        else if (!strcmp(name, "-wl"))  // 페이지 아웃 데몬을 깨우는 빈 프레임 수
+            vm_pageout_low = atoi(value);
+        else if (!strcmp(name, "-wh"))  // 페이지 아웃 데몬이 채워 두는 빈 프레임 수
+            vm_pageout_high = atoi(value);
+        else if (!strcmp(name, "-fa"))  // 읽기 폴트 때 함께 올리는 페이지 수
+            vm_fault_around_pages = atoi(value);
+        else if (!strcmp(name, "-zs"))  // 압축 스왑 풀의 크기 (페이지 수)
+            vm_zswap_pages = atoi(value);
+        else if (!strcmp(name, "-ksm"))  // KSM 스캐너가 한 번에 검사하는 프레임 수
+            vm_ksm_pages = atoi(value);
+        else if (!strcmp(name, "-thp"))  // 큰 anon 영역을 2 MB 페이지로 매핑
+            vm_thp = true;
+        else if (!strcmp(name, "-rss"))  // 새 프로세스의 RSS 상한 (페이지 수)
+            vm_rss_limit = atoi(value);
 #endif
         else
             PANIC("unknown option `%s' (use -h for help)", name);  // 알려지지 않은 옵션 처리
@@ -354,6 +371,15 @@ static void usage(void) {
         "  -mlfqs             Use multi-level feedback queue scheduler.\n"  // 멀티 레벨 피드백 큐 스케줄러를 사용합니다.
 #ifdef USERPROG
         "  -ul=COUNT          Limit user memory to COUNT pages.\n"  // 사용자 메모리를 count 페이지로 제한
+#endif
+#ifdef VM
+        "  -wl=COUNT          Wake the pageout daemon below COUNT free frames.\n"  // 빈 프레임이 count 보다 적으면 데몬을 깨움
+        "  -wh=COUNT          Let the pageout daemon free up to COUNT frames.\n"   // 데몬이 count 개까지 프레임을 비움
+        "  -fa=PAGES          Map up to PAGES pages around a read fault.\n"       // 읽기 폴트 주변 page 개를 함께 매핑
+        "  -zs=PAGES          Keep up to PAGES pages of compressed swap in RAM.\n" // 압축 스왑 풀 크기, 0 이면 끔
+        "  -ksm=PAGES         Scan PAGES frames for identical pages every 100 ms.\n" // 0 이면 KSM 을 끔
+        "  -thp               Back aligned 2 MB zero-filled regions with 2 MB pages.\n" // 투명한 2 MB 페이지
+        "  -rss=PAGES         Limit each process to PAGES resident pages.\n"   // 0 이면 제한 없음
 #endif
     );
     power_off();
@@ -364,6 +390,11 @@ static void usage(void) {
 /* Powers down the machine we're running on,
    as long as we're running on Bochs or QEMU. */
 void power_off(void) {
+#ifdef VM
+    // 큐에 남은 mmap writeback 을 디스크에 내린다. 인터럽트가 꺼진 채 불렸으면 (panic) 기다릴 수 없다.
+    if (intr_get_level() == INTR_ON)
+        vm_writeback_wait(NULL);
+#endif
 #ifdef FILESYS
     filesys_done();  // 파일 시스템 정리
 #endif
@@ -389,4 +420,7 @@ static void print_stats(void) {
 #ifdef USERPROG
     exception_print_stats();  // 예외 통계
 #endif
+#ifdef VM
+    vm_print_stats();  // 페이지 교체 통계
+#endif
 }
@@ -2,21 +2,269 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "intrinsic.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
 
+static long long pt_alloc_cnt;   /* 페이지 테이블용으로 할당한 페이지 수 */
+static long long huge_map_cnt;   /* 2 MB 페이지로 매핑한 수 */
+static long long huge_split_cnt; /* 2 MB 매핑을 4 KB 페이지 테이블로 쪼갠 수 */
+
+/* 2 MB 매핑을 쪼갤 때 쓸 페이지 테이블.
+ * 2 MB 페이지를 매핑할 때 한 장씩 미리 받아 두므로 쪼개기는 메모리를 할당하지 않고
+ * 실패하지도 않습니다 (Linux 의 pgtable deposit 과 같은 방식). 받아 둘 수 없으면
+ * 2 MB 매핑이 실패하고 폴트는 4 KB 로 처리됩니다. 페이지의 첫 8 바이트로 이어진
+ * 리스트이며, 인터럽트를 끄고 다룹니다. */
+static uint64_t *split_reserve;
+static size_t split_reserve_cnt;   /* = 지금 살아 있는 2 MB 매핑의 수 */
+
+/* Process-context identifiers (PCIDs).
+ *
+ * With CR4.PCIDE set, TLB entries are tagged with the 12-bit PCID in the
+ * low bits of CR3, and loading CR3 with bit 63 set keeps them.  A switch
+ * back to a recently run process then finds its translations still in
+ * the TLB.  Like Linux, only a few PCIDs are handed out: each slot
+ * remembers the pml4 it belongs to and the generation of its last use,
+ * and the slot used longest ago is recycled for a new address space.  A
+ * recycled PCID, and one whose entries may be stale, is loaded without
+ * bit 63 so the CPU flushes its old entries first.  PCID 0 is base_pml4.
+ *
+ * Changing a PTE of an address space that is not running can no longer
+ * be ignored, since its entries survive in the TLB.  tlb_invalidate()
+ * drops them with INVPCID when the CPU has it and otherwise marks the
+ * slot stale. */
+#define CR4_PCIDE (1UL << 17)
+#define CR3_NOFLUSH (1UL << 63)
+#define PCID_SLOTS 16              /* PCID 1 ~ 16 */
+
+struct pcid_slot {
+    uint64_t *pml4;                /* 이 PCID 를 쓰는 주소 공간, 없으면 NULL */
+    uint64_t gen;                  /* 마지막으로 활성화된 세대 */
+    bool stale;                    /* 다음 활성화 때 TLB 를 비워야 함 */
+};
+
+static bool pcid_enabled;
+static bool invpcid_enabled;
+static struct pcid_slot pcid_slots[PCID_SLOTS];
+static uint64_t pcid_gen;          /* 활성화할 때마다 1 씩 늘어나는 세대 */
+static long long pcid_keep_cnt;    /* TLB 를 비우지 않고 전환한 수 */
+static long long pcid_flush_cnt;   /* PCID 를 재활용하거나 stale 이라 비우며 전환한 수 */
+static long long pcid_remote_cnt;  /* 실행 중이 아닌 주소 공간의 TLB 항목을 버린 수 */
+static long long tlb_batch_page_cnt;  /* batch 로 모은 무효화 수 */
+static long long tlb_batch_flush_cnt; /* batch 가 커서 주소 공간 전체를 비운 수 */
+
+/* Turns on PCIDs if the CPU supports them.  Must be called while
+ * base_pml4 is active with PCID 0. */
+/* CPU 가 지원하면 PCID 를 켭니다. base_pml4 가 PCID 0 으로 활성화된 상태에서 불러야 합니다. */
+void pcid_init(void) {
+    uint32_t regs[4];
+
+    cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+    cpuid(1, 0, regs);
+    if (!(regs[2] & (1 << 17)))    // CPUID.01H:ECX.PCID
+        return;
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        invpcid_enabled = (regs[1] & (1 << 10)) != 0;  // CPUID.07H:EBX.INVPCID
+    }
+    lcr4(rcr4() | CR4_PCIDE);
+    pcid_enabled = true;
+}
+
+/* Returns true if PML4 is the address space the CPU is running in. */
+static bool pml4_is_active(uint64_t *pml4) {
+    return PTE_ADDR(rcr3()) == vtop(pml4);
+}
+
+/* 인터럽트를 끈 상태에서 PML4 가 가진 PCID 슬롯을 찾습니다. 없으면 NULL. */
+static struct pcid_slot *pcid_lookup(uint64_t *pml4) {
+    for (struct pcid_slot *slot = pcid_slots; slot < pcid_slots + PCID_SLOTS; slot++)
+        if (slot->pml4 == pml4)
+            return slot;
+    return NULL;
+}
+
+/* 현재 스레드가 무효화를 모으고 있으면 그 batch 를 반환합니다. */
+static struct tlb_batch *tlb_batch_current(void) {
+#ifdef USERPROG
+    return thread_current()->tlb_batch;
+#else
+    return NULL;
+#endif
+}
+
+/* Drops the TLB entries for user virtual page VA of PML4, whether or not
+ * PML4 is running.  Inside a TLB batch for PML4 the page is only
+ * recorded. */
+/* PML4 의 VA 에 대한 TLB 항목을 버립니다. PML4 가 실행 중이 아니어도 됩니다.
+ * PML4 에 대한 batch 가 열려 있으면 주소만 기록해 두고 tlb_batch_end() 에서 버립니다. */
+static void tlb_invalidate(uint64_t *pml4, const void *va) {
+    struct tlb_batch *batch = tlb_batch_current();
+    if (batch != NULL && batch->pml4 == pml4) {
+        if (batch->cnt < TLB_BATCH_PAGES)
+            batch->va[batch->cnt] = (uint64_t)va;
+        batch->cnt++;
+        return;
+    }
+    if (pml4_is_active(pml4)) {
+        invlpg((uint64_t)va);
+        return;
+    }
+    // PCID 가 없으면 다른 주소 공간의 항목은 CR3 를 바꿀 때 모두 사라진다
+    if (!pcid_enabled)
+        return;
+    enum intr_level old_level = intr_disable();
+    struct pcid_slot *slot = pcid_lookup(pml4);
+    if (slot != NULL) {
+        if (invpcid_enabled)
+            invpcid(0, slot - pcid_slots + 1, (uint64_t)va);  // 한 주소만
+        else
+            slot->stale = true;
+        pcid_remote_cnt++;
+    }
+    intr_set_level(old_level);
+}
+
+#ifdef USERPROG
+/* Drops every TLB entry of PML4.  With PCIDs only PML4's own entries go. */
+/* PML4 의 모든 TLB 항목을 버립니다. */
+static void tlb_flush(uint64_t *pml4) {
+    if (pml4_is_active(pml4)) {
+        // PCID 를 쓰면 bit 63 이 꺼진 채 다시 읽혀 오므로 현재 PCID 만 비워진다
+        lcr3(rcr3());
+        return;
+    }
+    if (!pcid_enabled)
+        return;
+    enum intr_level old_level = intr_disable();
+    struct pcid_slot *slot = pcid_lookup(pml4);
+    if (slot != NULL)
+        slot->stale = true;
+    intr_set_level(old_level);
+}
+
+/* Starts gathering the TLB invalidations that this thread makes on PML4,
+ * such as those of pml4_clear_page(), into BATCH, so that tearing down
+ * many pages costs one flush instead of one invlpg per page.
+ *
+ * Until tlb_batch_end(), cleared pages may still be reachable through
+ * the TLB of PML4, even though their frames may already have been
+ * freed.  The caller must therefore end the batch before PML4 runs user
+ * code again, and must not touch the affected user pages itself in
+ * between.  A PML4 that is not running cannot use its entries anyway. */
+/* 이 스레드가 PML4 에 대해 하는 TLB 무효화를 BATCH 에 모읍니다. 많은 페이지를 해제할 때
+ * 페이지마다 invlpg 를 하는 대신 tlb_batch_end() 에서 한 번에 버립니다.
+ * 그 사이에는 지운 페이지가 아직 TLB 로 닿을 수 있으므로 PML4 가 사용자 코드를 다시
+ * 실행하기 전에 batch 를 끝내야 하고, 그 페이지들을 직접 건드려서도 안 됩니다. */
+void tlb_batch_begin(struct tlb_batch *batch, uint64_t *pml4) {
+    struct thread *curr = thread_current();
+
+    batch->pml4 = pml4;
+    batch->cnt = 0;
+    batch->prev = curr->tlb_batch;
+    curr->tlb_batch = batch;
+}
+
+/* Ends BATCH and drops the gathered TLB entries: page by page for a
+ * small batch, by flushing the whole address space for a large one. */
+/* BATCH 를 끝내고 모은 TLB 항목을 버립니다. 적으면 한 페이지씩, 많으면 주소 공간 전체를
+ * 한 번에 비웁니다. */
+void tlb_batch_end(struct tlb_batch *batch) {
+    struct thread *curr = thread_current();
+
+    ASSERT(curr->tlb_batch == batch);
+    curr->tlb_batch = batch->prev;
+    if (batch->cnt > TLB_BATCH_PAGES) {
+        tlb_flush(batch->pml4);
+        tlb_batch_flush_cnt++;
+    } else {
+        // 바깥쪽 batch 가 같은 주소 공간이면 거기에 다시 모인다
+        for (size_t i = 0; i < batch->cnt; i++)
+            tlb_invalidate(batch->pml4, (void *)batch->va[i]);
+    }
+    tlb_batch_page_cnt += batch->cnt;
+}
+#endif
+
+/* 페이지 테이블로 쓸 페이지를 커널 풀에서 받습니다. */
+static uint64_t *pt_alloc(enum palloc_flags flags) {
+    uint64_t *pt = palloc_get_page(flags | PAL_ZERO);
+    if (pt != NULL)
+        pt_alloc_cnt++;
+    return pt;
+}
+
+/* Returns true if the PDE maps a 2 MB page instead of a page table. */
+static bool pde_is_huge(uint64_t pde) {
+    return (pde & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS);
+}
+
+/* 2 MB 매핑 하나를 위해 페이지 테이블 PT 를 쪼개기용으로 맡겨 둡니다. */
+static void split_reserve_put(uint64_t *pt) {
+    enum intr_level old_level = intr_disable();
+    *(uint64_t **)pt = split_reserve;
+    split_reserve = pt;
+    split_reserve_cnt++;
+    intr_set_level(old_level);
+}
+
+/* 맡겨 둔 페이지 테이블을 하나 꺼냅니다. 인터럽트를 끈 상태에서 호출해야 합니다. */
+static uint64_t *split_reserve_take(void) {
+    uint64_t *pt = split_reserve;
+
+    ASSERT(intr_get_level() == INTR_OFF);
+    ASSERT(pt != NULL);
+    split_reserve = *(uint64_t **)pt;
+    split_reserve_cnt--;
+    return pt;
+}
+
+/* 2 MB 매핑 하나가 사라졌으므로 그 몫으로 맡겨 둔 페이지 테이블을 돌려줍니다. */
+static void split_reserve_release(void) {
+    enum intr_level old_level = intr_disable();
+    uint64_t *pt = split_reserve_take();
+    intr_set_level(old_level);
+    palloc_free_page(pt);
+}
+
+/* 2 MB 페이지를 매핑한 PDE 를 같은 프레임들을 가리키는 512 개의 PTE 로 쪼갭니다.
+ * 각 PTE 는 PDE 의 권한과 accessed/dirty 비트를 물려받습니다. 4 KB 단위로 PTE 를
+ * 고치려는 모든 walk 가 이 함수를 거치므로, 부분 munmap, 쫓아내기, fork 의 COW 가
+ * 모두 자연스럽게 쪼개진 페이지 테이블 위에서 일합니다. 페이지 테이블은 매핑할 때
+ * 맡겨 둔 것을 쓰므로 메모리가 부족해도 실패하지 않습니다. */
+static void pde_split(uint64_t *pde, const uint64_t va) {
+    // 다른 스레드가 같은 PDE 를 먼저 쪼갰을 수 있으므로 확인과 교체를 한 번에 한다
+    enum intr_level old_level = intr_disable();
+    if (pde_is_huge(*pde)) {
+        uint64_t *pt = split_reserve_take();
+        uint64_t pa = PTE_ADDR(*pde);
+        uint64_t flags = *pde & (PTE_P | PTE_W | PTE_U | PTE_A | PTE_D);
+        for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++)
+            pt[i] = (pa + i * PGSIZE) | flags;
+        *pde = vtop(pt) | PTE_U | PTE_W | PTE_P;
+        // 어느 주소 공간의 PDE 인지 모르므로 현재 TLB 에서 무조건 지운다 (다른 공간이면 무해)
+        invlpg(va);
+        huge_split_cnt++;
+    }
+    intr_set_level(old_level);
+}
+
 static uint64_t *pgdir_walk(uint64_t *pdp, const uint64_t va, int create) {
     int idx = PDX(va);
     if (pdp) {
         uint64_t *pte = (uint64_t *)pdp[idx];
-        if (!((uint64_t)pte & PTE_P)) {
+        if (pde_is_huge(pdp[idx]))
+            pde_split(&pdp[idx], va);
+        else if (!((uint64_t)pte & PTE_P)) {
             if (create) {
-                uint64_t *new_page = palloc_get_page(PAL_ZERO);
+                uint64_t *new_page = pt_alloc(0);
                 if (new_page)
                     pdp[idx] = vtop(new_page) | PTE_U | PTE_W | PTE_P;
                 else
@@ -37,7 +285,7 @@ static uint64_t *pdpe_walk(uint64_t *pdpe, const uint64_t va, int create) {
         uint64_t *pde = (uint64_t *)pdpe[idx];
         if (!((uint64_t)pde & PTE_P)) {
             if (create) {
-                uint64_t *new_page = palloc_get_page(PAL_ZERO);
+                uint64_t *new_page = pt_alloc(0);
                 if (new_page) {
                     pdpe[idx] = vtop(new_page) | PTE_U | PTE_W | PTE_P;
                     allocated = 1;
@@ -69,7 +317,7 @@ uint64_t *pml4e_walk(uint64_t *pml4e, const uint64_t va, int create) {
         uint64_t *pdpe = (uint64_t *)pml4e[idx];
         if (!((uint64_t)pdpe & PTE_P)) {
             if (create) {
-                uint64_t *new_page = palloc_get_page(PAL_ZERO);
+                uint64_t *new_page = pt_alloc(0);
                 if (new_page) {
                     pml4e[idx] = vtop(new_page) | PTE_U | PTE_W | PTE_P;
                     allocated = 1;
@@ -87,6 +335,32 @@ uint64_t *pml4e_walk(uint64_t *pml4e, const uint64_t va, int create) {
     return pte;
 }
 
+/* Returns the address of the page directory entry for VA in PML4, or a
+ * null pointer if the page directory is missing and CREATE is false or
+ * cannot be allocated.  The PDE itself is never split. */
+static uint64_t *pml4_pde(uint64_t *pml4, const uint64_t va, bool create) {
+    uint64_t *table = pml4;
+    int idx[] = {PML4(va), PDPE(va)};
+
+    for (unsigned level = 0; level < 2; level++) {
+        uint64_t *entry = &table[idx[level]];
+        if (!(*entry & PTE_P)) {
+            uint64_t *new_page = create ? pt_alloc(0) : NULL;
+            if (new_page == NULL)
+                return NULL;
+            *entry = vtop(new_page) | PTE_U | PTE_W | PTE_P;
+        }
+        table = ptov(PTE_ADDR(*entry));
+    }
+    return &table[PDX(va)];
+}
+
+/* 2 MB 페이지로 매핑된 경우 VA 의 PDE 를, 아니면 NULL 을 반환합니다. */
+static uint64_t *pml4_huge_pde(uint64_t *pml4, const void *va) {
+    uint64_t *pde = pml4_pde(pml4, (uint64_t)va, false);
+    return pde != NULL && pde_is_huge(*pde) ? pde : NULL;
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -113,7 +387,8 @@ static bool pt_for_each(uint64_t *pt, pte_for_each_func *func, void *aux, unsign
 static bool pgdir_for_each(uint64_t *pdp, pte_for_each_func *func, void *aux, unsigned pml4_index, unsigned pdp_index) {
     for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
         uint64_t *pte = ptov((uint64_t *)pdp[i]);
-        if (((uint64_t)pte) & PTE_P)
+        // 2 MB 페이지에는 FUNC 에 넘길 4 KB PTE 가 없다
+        if ((((uint64_t)pte) & PTE_P) && !pde_is_huge(pdp[i]))
             if (!pt_for_each((uint64_t *)PTE_ADDR(pte), func, aux, pml4_index, pdp_index, i))
                 return false;
     }
@@ -153,7 +428,10 @@ static void pt_destroy(uint64_t *pt) {
 static void pgdir_destroy(uint64_t *pdp) {
     for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
         uint64_t *pte = ptov((uint64_t *)pdp[i]);
-        if (((uint64_t)pte) & PTE_P)
+        // 2 MB 페이지의 프레임들은 VM 의 프레임 테이블이 한 장씩 해제한다
+        if (pde_is_huge(pdp[i]))
+            split_reserve_release();
+        else if (((uint64_t)pte) & PTE_P)
             pt_destroy(PTE_ADDR(pte));
     }
     palloc_free_page((void *)pdp);
@@ -174,6 +452,15 @@ void pml4_destroy(uint64_t *pml4) {
         return;
     ASSERT(pml4 != base_pml4);
 
+    // 같은 주소에 새 pml4 가 만들어져도 이전 TLB 항목을 물려받지 않도록 PCID 를 놓는다
+    if (pcid_enabled) {
+        enum intr_level old_level = intr_disable();
+        struct pcid_slot *slot = pcid_lookup(pml4);
+        if (slot != NULL)
+            slot->pml4 = NULL;
+        intr_set_level(old_level);
+    }
+
     /* if PML4 (vaddr) >= 1, it's kernel space by define. */
     uint64_t *pdpe = ptov((uint64_t *)pml4[0]);
     if (((uint64_t)pdpe) & PTE_P)
@@ -184,7 +471,38 @@ void pml4_destroy(uint64_t *pml4) {
 /* Loads page directory PD into the CPU's page directory base
  * register. */
 void pml4_activate(uint64_t *pml4) {
-    lcr3(vtop(pml4 ? pml4 : base_pml4));
+    if (!pcid_enabled) {
+        lcr3(vtop(pml4 ? pml4 : base_pml4));
+        return;
+    }
+    // 커널 매핑은 바뀌지 않으므로 base_pml4 (PCID 0) 로 갈 때는 비울 것이 없다
+    if (pml4 == NULL) {
+        lcr3(vtop(base_pml4) | CR3_NOFLUSH);
+        return;
+    }
+
+    enum intr_level old_level = intr_disable();
+    struct pcid_slot *slot = pcid_lookup(pml4);
+    bool flush = slot == NULL || slot->stale;
+    if (slot == NULL) {
+        // 가장 오래전에 쓰인 슬롯을 재활용한다. 그 PCID 의 항목은 아래에서 비워진다
+        slot = pcid_slots;
+        for (struct pcid_slot *s = pcid_slots; s < pcid_slots + PCID_SLOTS; s++)
+            if (s->pml4 == NULL || s->gen < slot->gen) {
+                slot = s;
+                if (s->pml4 == NULL)
+                    break;
+            }
+        slot->pml4 = pml4;
+    }
+    slot->stale = false;
+    slot->gen = ++pcid_gen;
+    if (flush)
+        pcid_flush_cnt++;
+    else
+        pcid_keep_cnt++;
+    lcr3(vtop(pml4) | (slot - pcid_slots + 1) | (flush ? 0 : CR3_NOFLUSH));
+    intr_set_level(old_level);
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -194,6 +512,10 @@ void pml4_activate(uint64_t *pml4) {
 void *pml4_get_page(uint64_t *pml4, const void *uaddr) {
     ASSERT(is_user_vaddr(uaddr));
 
+    uint64_t *pde = pml4_huge_pde(pml4, uaddr);
+    if (pde != NULL)
+        return ptov(PTE_ADDR(*pde)) + ((uint64_t)uaddr & (HPGSIZE - 1));
+
     uint64_t *pte = pml4e_walk(pml4, (uint64_t)uaddr, 0);
 
     if (pte && (*pte & PTE_P))
@@ -222,6 +544,74 @@ bool pml4_set_page(uint64_t *pml4, void *upage, void *kpage, bool rw) {
     return pte != NULL;
 }
 
+/* Maps the 2 MB user virtual region starting at UPAGE in PML4 to the
+ * physically contiguous frames starting at kernel virtual address KPAGE
+ * with a single PDE.  Both must be 2 MB aligned and no page of the region
+ * may be mapped; an empty page table left over from earlier mappings is
+ * freed.  Returns false if the region is in use or memory allocation
+ * failed. */
+/* UPAGE 부터 2 MB 의 사용자 영역을 KPAGE 부터 물리적으로 연속된 프레임들에 PDE 하나로
+ * 매핑합니다. 영역 안에 매핑된 페이지가 있으면 false 를 반환합니다. */
+bool pml4_set_huge_page(uint64_t *pml4, void *upage, void *kpage, bool rw) {
+    ASSERT((uint64_t)upage % HPGSIZE == 0);
+    ASSERT(vtop(kpage) % HPGSIZE == 0);
+    ASSERT(is_user_vaddr(upage + HPGSIZE - 1));
+    ASSERT(pml4 != base_pml4);
+
+    uint64_t *pde = pml4_pde(pml4, (uint64_t)upage, true);
+    if (pde == NULL)
+        return false;
+    // 나중에 쪼갤 때 쓸 페이지 테이블: 비어 있는 기존 페이지 테이블이 있으면 그것을 맡긴다
+    uint64_t *pt;
+    if (*pde & PTE_P) {
+        if (*pde & PTE_PS)
+            return false;
+        pt = ptov(PTE_ADDR(*pde));
+        for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++)
+            if (pt[i] & PTE_P)
+                return false;
+    } else if ((pt = pt_alloc(0)) == NULL)
+        return false;
+    split_reserve_put(pt);
+    *pde = vtop(kpage) | PTE_PS | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+    // 지운 페이지 테이블을 가리키던 캐시된 PDE 를 버린다
+    tlb_invalidate(pml4, upage);
+    huge_map_cnt++;
+    return true;
+}
+
+/* Removes every 2 MB mapping of PML4 at once, without splitting them
+ * into 4 KB page tables first.  Used when the address space is torn
+ * down; the frames themselves are freed by the caller.  PML4 may be
+ * null for a thread that has not loaded a user program yet. */
+/* PML4 의 모든 2 MB 매핑을 쪼개지 않고 한 번에 지웁니다. 주소 공간을 없앨 때 씁니다.
+ * 프레임은 호출자가 해제합니다. 아직 사용자 프로그램을 올리지 않은 스레드는 PML4 가 NULL 입니다. */
+void pml4_clear_huge_pages(uint64_t *pml4) {
+    if (pml4 == NULL)
+        return;
+    uint64_t *pdpe = (uint64_t *)pml4[0];
+
+    if (!((uint64_t)pdpe & PTE_P))
+        return;
+    pdpe = ptov(PTE_ADDR(pdpe));
+    for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
+        if (!(pdpe[i] & PTE_P))
+            continue;
+        uint64_t *pd = ptov(PTE_ADDR(pdpe[i]));
+        for (unsigned j = 0; j < PGSIZE / sizeof(uint64_t *); j++)
+            if (pde_is_huge(pd[j])) {
+                pd[j] = 0;
+                tlb_invalidate(pml4, (void *)(((uint64_t)i << PDPESHIFT) | ((uint64_t)j << PDXSHIFT)));
+                split_reserve_release();
+            }
+    }
+}
+
+/* Returns true if UPAGE is mapped in PML4 as part of a 2 MB page. */
+bool pml4_is_huge(uint64_t *pml4, const void *upage) {
+    return pml4_huge_pde(pml4, upage) != NULL;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
@@ -235,17 +625,49 @@ void pml4_clear_page(uint64_t *pml4, void *upage) {
 
     if (pte != NULL && (*pte & PTE_P) != 0) {
         *pte &= ~PTE_P;
-        if (rcr3() == vtop(pml4))
-            invlpg((uint64_t)upage);
+        tlb_invalidate(pml4, upage);
     }
 }
 
+/* Moves the page table entry of user virtual page FROM to user
+ * virtual page TO in PML4, keeping the frame and every flag bit, and
+ * leaves FROM unmapped.  TO must not be mapped.  If FROM is not
+ * present, TO is left unmapped and no page table is allocated for it,
+ * so this cannot fail.  Returns false, without changing anything, if a
+ * page table for TO could not be allocated. */
+bool pml4_move_page(uint64_t *pml4, void *from, void *to) {
+    ASSERT(pg_ofs(from) == 0);
+    ASSERT(pg_ofs(to) == 0);
+    ASSERT(is_user_vaddr(from));
+    ASSERT(is_user_vaddr(to));
+    ASSERT(pml4 != base_pml4);
+
+    uint64_t *src = pml4e_walk(pml4, (uint64_t)from, false);
+    if (src == NULL || !(*src & PTE_P)) {
+        // 옮길 매핑이 없으면 TO 쪽 페이지 테이블을 만들 필요도 없다
+        if (src != NULL)
+            *src = 0;
+        return true;
+    }
+
+    uint64_t *dst = pml4e_walk(pml4, (uint64_t)to, 1);
+    if (dst == NULL)
+        return false;
+    *dst = *src;
+    *src = 0;
+    tlb_invalidate(pml4, from);
+    return true;
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PML4 is dirty,
  * that is, if the page has been modified since the PTE was
  * installed.
  * Returns false if PML4 contains no PTE for VPAGE. */
 bool pml4_is_dirty(uint64_t *pml4, const void *vpage) {
-    uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+    // 2 MB 페이지는 쪼개지 않고 PDE 의 비트를 본다 (512 페이지 중 하나라도 쓰였으면 dirty)
+    uint64_t *pte = pml4_huge_pde(pml4, vpage);
+    if (pte == NULL)
+        pte = pml4e_walk(pml4, (uint64_t)vpage, false);
     return pte != NULL && (*pte & PTE_D) != 0;
 }
 
@@ -259,8 +681,7 @@ void pml4_set_dirty(uint64_t *pml4, const void *vpage, bool dirty) {
         else
             *pte &= ~(uint32_t)PTE_D;
 
-        if (rcr3() == vtop(pml4))
-            invlpg((uint64_t)vpage);
+        tlb_invalidate(pml4, vpage);
     }
 }
 
@@ -269,21 +690,57 @@ void pml4_set_dirty(uint64_t *pml4, const void *vpage, bool dirty) {
  * installed and the last time it was cleared.  Returns false if
  * PML4 contains no PTE for VPAGE. */
 bool pml4_is_accessed(uint64_t *pml4, const void *vpage) {
-    uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+    uint64_t *pte = pml4_huge_pde(pml4, vpage);
+    if (pte == NULL)
+        pte = pml4e_walk(pml4, (uint64_t)vpage, false);
     return pte != NULL && (*pte & PTE_A) != 0;
 }
 
 /* Sets the accessed bit to ACCESSED in the PTE for virtual page
    VPAGE in PD. */
 void pml4_set_accessed(uint64_t *pml4, const void *vpage, bool accessed) {
-    uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+    // accessed 비트는 교체 정책의 힌트일 뿐이므로 2 MB 페이지 전체에 한꺼번에 적용해도 된다.
+    // 시계 알고리즘이 지나갈 때마다 쪼개지 않게 한다
+    uint64_t *pte = pml4_huge_pde(pml4, vpage);
+    if (pte == NULL)
+        pte = pml4e_walk(pml4, (uint64_t)vpage, false);
     if (pte) {
         if (accessed)
             *pte |= PTE_A;
         else
             *pte &= ~(uint32_t)PTE_A;
 
-        if (rcr3() == vtop(pml4))
+        // 다른 주소 공간의 항목까지 버리면 시계 알고리즘이 지나갈 때마다 그 PCID 를
+        // 비우게 된다. 남은 항목 때문에 accessed 가 늦게 켜지는 것은 감수한다
+        if (pml4_is_active(pml4))
             invlpg((uint64_t)vpage);
     }
 }
+
+/* Sets the writable bit to WRITABLE in the PTE for virtual page
+   VPAGE in PML4.  Other bits in the page table entry are preserved. */
+void pml4_set_writable(uint64_t *pml4, const void *vpage, bool writable) {
+    uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+    if (pte) {
+        if (writable)
+            *pte |= PTE_W;
+        else
+            *pte &= ~(uint64_t)PTE_W;
+
+        tlb_invalidate(pml4, vpage);
+    }
+}
+
+/* Prints page table statistics. */
+/* 페이지 테이블 통계를 출력합니다. */
+void mmu_print_stats(void) {
+    printf("MMU: %lld page-table pages allocated, %lld 2 MB pages mapped, %lld split, %zu reserved for splitting\n",
+           pt_alloc_cnt, huge_map_cnt, huge_split_cnt, split_reserve_cnt);
+    printf("MMU: %lld TLB invalidations batched, %lld batches flushed the whole address space\n",
+           tlb_batch_page_cnt, tlb_batch_flush_cnt);
+    if (pcid_enabled)
+        printf("MMU: PCID switches kept the TLB %lld times, flushed %lld times, %lld remote invalidations (%s)\n",
+               pcid_keep_cnt, pcid_flush_cnt, pcid_remote_cnt, invpcid_enabled ? "INVPCID" : "deferred");
+    else
+        printf("MMU: PCID not supported, every switch flushes the TLB\n");
+}
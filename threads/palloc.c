@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -31,6 +32,7 @@ struct pool {
 	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	size_t free_cnt;                /* Number of free pages in used_map. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -42,6 +44,7 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void pool_count_free (struct pool *, size_t delta);
 
 /* multiboot info */
 struct multiboot_info {
@@ -224,11 +227,13 @@ split:
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
 				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool->free_cnt += page_cnt;
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
 				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool->free_cnt += page_cnt;
 			}
 		}
 	}
@@ -265,6 +270,8 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 
 	lock_acquire (&pool->lock);
 	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+	if (page_idx != BITMAP_ERROR)
+		pool_count_free (pool, -page_cnt);
 	lock_release (&pool->lock);
 	void *pages;
 
@@ -284,6 +291,42 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
+/* Like palloc_get_multiple(), but the physical address of the
+   first page is a multiple of ALIGN_CNT pages, as a 2 MB page
+   mapping requires.  Only aligned runs are considered, so this
+   can fail even when palloc_get_multiple() would succeed. */
+void *
+palloc_get_aligned (enum palloc_flags flags, size_t page_cnt,
+		size_t align_cnt) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t align = align_cnt * PGSIZE;
+	size_t first = (align - vtop (pool->base) % align) % align / PGSIZE;
+	size_t page_idx = BITMAP_ERROR;
+	void *pages = NULL;
+
+	ASSERT (align_cnt > 0);
+
+	lock_acquire (&pool->lock);
+	for (size_t idx = first;
+			idx + page_cnt <= bitmap_size (pool->used_map); idx += align_cnt)
+		if (bitmap_none (pool->used_map, idx, page_cnt)) {
+			bitmap_set_multiple (pool->used_map, idx, page_cnt, true);
+			pool_count_free (pool, -page_cnt);
+			page_idx = idx;
+			break;
+		}
+	lock_release (&pool->lock);
+
+	if (page_idx != BITMAP_ERROR) {
+		pages = pool->base + PGSIZE * page_idx;
+		if (flags & PAL_ZERO)
+			memset (pages, 0, PGSIZE * page_cnt);
+	} else if (flags & PAL_ASSERT)
+		PANIC ("palloc_get: out of pages");
+
+	return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -320,6 +363,7 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #endif
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
 	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	pool_count_free (pool, page_cnt);
 }
 
 /* Frees the page at PAGE. */
@@ -328,6 +372,22 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Returns the number of free pages in the user pool.  The count
+   is kept up to date by the allocator, so this is cheap enough to
+   call on every page fault. */
+size_t
+palloc_user_free_cnt (void) {
+	return user_pool.free_cnt;
+}
+
+/* Returns the first page of the user pool and stores the number of
+   pages it spans, used or not, in *PAGE_CNT. */
+void *
+palloc_user_pool (size_t *page_cnt) {
+	*page_cnt = bitmap_size (user_pool.used_map);
+	return user_pool.base;
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
@@ -340,6 +400,7 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
 	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
 	p->base = (void *) start;
+	p->free_cnt = 0;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
@@ -347,6 +408,17 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
 	*bm_base += bm_pages;
 }
 
+/* Adds DELTA, which may be a negated count, to POOL's free page
+   count.  Pages are freed without the pool lock, sometimes with
+   interrupts already off while a dying thread is destroyed, so the
+   update is made atomic by disabling interrupts. */
+static void
+pool_count_free (struct pool *pool, size_t delta) {
+	enum intr_level old_level = intr_disable ();
+	pool->free_cnt += delta;
+	intr_set_level (old_level);
+}
+
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool
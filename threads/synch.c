@@ -260,7 +260,11 @@ lock_acquire (struct lock *lock) {
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 	struct thread *curr = thread_current();
+	enum intr_level old_level;
 
+	/* 보유자를 확인한 뒤 기부 목록에 들어가기 전에 보유자가 락을 놓으면
+	   이미 끝난 보유자의 목록에 남게 되므로, 락을 얻을 때까지 인터럽트를 끈다. */
+	old_level = intr_disable ();
 	if (lock->holder) {
 		curr->wait_on_lock = lock;
 		list_insert_ordered(&lock->holder->donations, &curr->donation_elem, thread_compare_donate_priority, NULL);
@@ -270,6 +274,7 @@ lock_acquire (struct lock *lock) {
   	sema_down (&lock->semaphore);
   	curr->wait_on_lock = NULL;
 	lock->holder = curr;
+	intr_set_level (old_level);
 }
 
 /* LOCK을 획득하려고 시도하고, 성공하면 true를 실패하면 false를 반환합니다.
@@ -310,11 +315,13 @@ lock_release (struct lock *lock) {
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
+	enum intr_level old_level = intr_disable ();
 	remove_with_lock(lock);
 	refresh_priority();
 
 	lock->holder = NULL;
 	sema_up (&lock->semaphore);
+	intr_set_level (old_level);
 }
 
 /* 현재 스레드가 LOCK을 보유하고 있는지 여부를 반환합니다. 
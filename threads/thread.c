@@ -864,6 +864,8 @@ void donate_priority(void) {
         if(!curr->wait_on_lock) 
             break;
         struct thread *holder = curr->wait_on_lock->holder;
+        if (holder == NULL)  // 방금 풀린 락: 깨어난 스레드가 아직 wait_on_lock 을 지우지 못했다
+            break;
         holder->priority = curr->priority;
         curr = holder;
     }
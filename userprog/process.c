@@ -873,19 +873,16 @@ bool lazy_load_segment(struct page *page, void *aux) { // anon 이든 file 이
     /* TODO: This called when the first page fault occurs on address VA. */
     /* TODO: VA is available when calling this function. */
 
-    struct aux * data = (struct aux *) aux;
-    uint32_t page_read_bytes = data->page_read_bytes;
-    uint32_t page_zero_bytes = data->page_zero_bytes;
-    off_t ofs = data->ofs;
-    struct file * file = data->file;
+    // aux 는 페이지가 속한 영역(struct vm_area), 읽을 위치는 영역 안에서의 위치로 계산한다
+    struct vm_area *area = aux;
+    size_t page_read_bytes = vm_area_page_read_bytes(area, page->va);
+    off_t ofs = vm_area_page_offset(area, page->va);
 
-    file_seek(file, ofs);
-    if (file_read(file, page->frame->kva, page_read_bytes) != (int)page_read_bytes) // 디스크에서 데이터를 읽어, 물리 프레임에 복사(파일에서 읽을 바이트만큼 읽어서 물리 프레임 주소로 복사)
+    if (vm_file_read_page(area->file, frame_kva(page->frame), page_read_bytes, ofs) != (int)page_read_bytes) // 디스크(또는 미리 읽어 둔 캐시)에서 데이터를 읽어, 물리 프레임에 복사(파일에서 읽을 바이트만큼 읽어서 물리 프레임 주소로 복사)
         return false;
     
-    // page 물리 메모리가 있는 해당 주소에서 page_read_bytes 만큼 떨어진 지점 부터 page_zero_bytes 만큼의 메모리 영역을 0으로 초기화
-    memset(page->frame->kva + page_read_bytes, 0, page_zero_bytes); 
-    // free(data);
+    // page 물리 메모리가 있는 해당 주소에서 page_read_bytes 만큼 떨어진 지점 부터 나머지 메모리 영역을 0으로 초기화
+    memset(frame_kva(page->frame) + page_read_bytes, 0, PGSIZE - page_read_bytes); 
     return true;
 }
 
@@ -909,30 +906,15 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
     ASSERT(pg_ofs(upage) == 0);
     ASSERT(ofs % PGSIZE == 0);
 
-    while (read_bytes > 0 || zero_bytes > 0) {
-        /* Do calculate how to fill this page.
-         * We will read PAGE_READ_BYTES bytes from FILE
-         * and zero the final PAGE_ZERO_BYTES bytes. */
-        size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-        size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-        /* TODO: Set up aux to pass information to the lazy_load_segment. */
-        // aux를 설정 후 lazy_load_segment에 정보를 제공
-        struct aux *aux = (struct aux *)malloc(sizeof(struct aux));
-        aux->file = file;
-        aux->ofs = ofs;
-        aux->page_read_bytes = page_read_bytes;
-        aux->writable = writable;
-        aux->page_zero_bytes = page_zero_bytes;
-
-        if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable, lazy_load_segment, aux))
-            return false;
-
-        /* Advance. */
-        read_bytes -= page_read_bytes;
-        zero_bytes -= page_zero_bytes;
-        upage += PGSIZE;
-        ofs += page_read_bytes;
+    // 세그먼트 전체를 영역 하나로 등록하고, 페이지는 처음 접근할 때 lazy_load_segment 로 채운다.
+    // 영역은 실행 파일을 따로 열어 가지고 있는다.
+    struct file *seg_file = file_reopen(file);
+    if (seg_file == NULL)
+        return false;
+    if (vm_area_create(&thread_current()->spt, upage, read_bytes + zero_bytes, VM_ANON, writable,
+                       seg_file, ofs, read_bytes) == NULL) {
+        file_close(seg_file);
+        return false;
     }
     return true;
 }
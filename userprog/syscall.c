@@ -37,6 +37,10 @@ int wait (pid_t pid);
 int exec(const char *cmd_line);
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int madvise (void *addr, size_t length, int advice);
+int msync (void *addr, size_t length, int flags);
+void *mremap (void *addr, size_t old_size, size_t new_size, int flags);
+int setrss (size_t pages);
 
 /* 시스템 호출.
  *
@@ -138,6 +142,18 @@ void syscall_handler(struct intr_frame *f UNUSED) {
         case SYS_MUNMAP:
             munmap(f->R.rdi);
             break;
+        case SYS_MADVISE:
+            f->R.rax = madvise((void *) f->R.rdi, f->R.rsi, f->R.rdx);
+            break;
+        case SYS_MSYNC:
+            f->R.rax = msync((void *) f->R.rdi, f->R.rsi, f->R.rdx);
+            break;
+        case SYS_MREMAP:
+            f->R.rax = (uint64_t) mremap((void *) f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+            break;
+        case SYS_SETRSS:
+            f->R.rax = setrss(f->R.rdi);
+            break;
         default:
             thread_exit();
             break;
@@ -151,7 +167,7 @@ void check_address(void *addr) {
     if (addr == NULL || !is_user_vaddr(addr))  // 사용자 영역 주소인지 확인
         exit(-1);
 
-    if (spt_find_page(&t->spt, addr) == NULL) // 할당받은 페이지를 확인
+    if (spt_lookup_page(&t->spt, addr) == NULL) // 할당받은 페이지(또는 영역)를 확인
     {
         exit(-1);
     }
@@ -165,17 +181,21 @@ struct page *is_valid_address(void *addr) {
     if (is_kernel_vaddr(addr) || addr == NULL)
         return NULL;
 
-    return spt_find_page(&curr->spt, addr);
+    return spt_lookup_page(&curr->spt, addr);
 }
 
 
 void check_valid_buffer(void *buffer, size_t size, bool writable) {
-    for (size_t i = 0; i < size; i++) {
+    /* 유효성은 페이지 단위로 결정되므로 buffer 가 걸친 페이지마다 한 번씩만 검사 */
+    for (void *p = buffer; p < buffer + size; p = pg_round_down(p) + PGSIZE) {
         /* buffer가 spt에 존재하는지 검사 */
-        struct page *page = is_valid_address(buffer + i);
+        struct page *page = is_valid_address(p);
 
         if (!page || (writable && !(page->writable)))
             exit(-1);
+        /* 커널이 직접 쓰므로 copy-on-write 나 zero 페이지를 미리 자기 프레임으로 바꿔 둔다 */
+        if (writable && !vm_prepare_write(p))
+            exit(-1);
     }
 }
 
@@ -411,15 +431,23 @@ void *mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
 
 	struct file *file = fd_to_fileptr(fd); /* fd로 file을 열고*/
 
-    struct page *page = spt_find_page(&thread_current()->spt,addr); // 기존 매핑된 페이지가 있는지
-    
     if (!is_user_vaddr(addr+length) || !is_user_vaddr(addr))
         return false;
     
-    if ((long)length <= 0 || fd == 0 || fd == 1 || fd == 2 || (offset % PGSIZE) != 0 || addr == NULL || page || addr != pg_round_down(addr) || !file)  // 매핑을 실패하는 조건
+    if ((long)length <= 0 || fd == 0 || fd == 1 || fd == 2 || (offset % PGSIZE) != 0 || addr == NULL || addr != pg_round_down(addr) || !file)  // 매핑을 실패하는 조건
         return false; 
 
-    return do_mmap(addr, length, writable, file, offset); // 매핑 정보를 전달 
+    // MAP_POPULATE 가 있으면 매핑하자마자 전체를 읽어서 이후의 폴트를 없앤다.
+    // 다 올리지 못하면 매핑을 없애고 실패한다.
+    bool populate = (writable & MAP_POPULATE) != 0;
+    writable &= ~MAP_POPULATE;
+
+    void *map = do_mmap(addr, length, writable, file, offset); // 매핑 정보를 전달 (다른 영역과 겹치면 실패)
+    if (map != NULL && populate && !vm_populate(map, length)) {
+        do_munmap(map);
+        return MAP_FAILED;
+    }
+    return map;
 
 }
 
@@ -427,3 +455,55 @@ void munmap (void *addr) {
 	// mmap에 대한 호출에 의해 반환된 가상주소 - 페이지의 시작주소
     do_munmap(addr);
 }
+
+/* ADDR 부터 LENGTH 바이트의 접근 패턴을 VM 에 알려 줍니다. 성공하면 0, 실패하면 -1
+ * MADV_WILLNEED 는 파일에서 읽을 내용을 readahead 스레드에 맡기고 기다리지 않지만,
+ * 스왑된 anon 페이지는 돌아오기 전에 스왑 디스크에서 읽습니다. */
+int madvise (void *addr, size_t length, int advice) {
+    bool ok;
+
+    switch (advice) {
+        case MADV_NORMAL:
+            ok = vm_advise(addr, length, VM_ADVICE_NORMAL);
+            break;
+        case MADV_RANDOM:
+            ok = vm_advise(addr, length, VM_ADVICE_RANDOM);
+            break;
+        case MADV_SEQUENTIAL:
+            ok = vm_advise(addr, length, VM_ADVICE_SEQUENTIAL);
+            break;
+        case MADV_WILLNEED: // 범위의 페이지를 미리 읽어 둔다
+            ok = vm_willneed(addr, length);
+            break;
+        case MADV_DONTNEED: // 범위의 페이지와 스왑 슬롯을 바로 버린다
+            ok = vm_dontneed(addr, length);
+            break;
+        default:
+            ok = false;
+            break;
+    }
+    return ok ? 0 : -1;
+}
+
+/* ADDR 부터 LENGTH 바이트 중 수정된 파일 페이지를 파일에 씁니다. 매핑은 그대로 남습니다.
+ * MS_SYNC 이면 디스크에 기록될 때까지 기다립니다. 성공하면 0, 실패하면 -1 */
+int msync (void *addr, size_t length, int flags) {
+    if (flags != MS_ASYNC && flags != MS_SYNC)
+        return -1;
+    return vm_msync(addr, length, flags == MS_SYNC) ? 0 : -1;
+}
+
+/* ADDR 에 있는 OLD_SIZE 바이트짜리 파일 매핑의 크기를 NEW_SIZE 로 바꿉니다.
+ * 뒤쪽이 비어 있지 않으면 MREMAP_MAYMOVE 가 있을 때만 다른 주소로 옮깁니다.
+ * 매핑의 새 주소를 반환하고, 실패하면 MAP_FAILED(NULL) */
+void *mremap (void *addr, size_t old_size, size_t new_size, int flags) {
+    if ((flags & ~MREMAP_MAYMOVE) != 0)
+        return NULL;
+    return do_mremap(addr, old_size, new_size, (flags & MREMAP_MAYMOVE) != 0);
+}
+
+/* 이 프로세스의 RSS 를 PAGES 페이지로 제한합니다. 0 이면 제한을 없앱니다.
+ * 상한은 fork 한 자식에게 물려주고 exec 후에도 남습니다. 성공하면 0, 실패하면 -1 */
+int setrss (size_t pages) {
+    return vm_set_rss_limit(pages) ? 0 : -1;
+}
@@ -4,7 +4,14 @@
 #include "threads/vaddr.h"
 #include "vm/vm.h"
 #include "lib/kernel/bitmap.h"
+#include "lib/kernel/lz.h"
 #include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "userprog/process.h"
+#include <stdio.h>
+#include <string.h>
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -13,6 +20,81 @@ static bool anon_swap_out(struct page *page);
 static void anon_destroy(struct page *page);
 
 struct bitmap *swap_table;
+static struct lock swap_lock; // swap_table 을 보호하는 락
+
+/* 한 페이지(스왑 슬롯 하나)가 차지하는 섹터 수 */
+#define SECTORS_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)
+
+/* 스왑 I/O 통계 */
+static long long swap_out_cnt;     /* 스왑 아웃한 페이지 수 */
+static long long swap_write_cnt;   /* 스왑 아웃에 쓴 디스크 명령 수 */
+static long long swap_in_cnt;      /* 스왑 인한 페이지 수 */
+static long long swap_clean_cnt;   /* 스왑 캐시 덕분에 쓰지 않고 내보낸 페이지 수 */
+static long long discard_cnt;      /* 실행 파일과 같아서 쓰지 않고 버린 페이지 수 */
+static long long reload_cnt;       /* 버린 뒤 실행 파일에서 다시 읽은 페이지 수 */
+
+struct zswap_entry;
+
+/* 각 스왑 슬롯의 사용 정보. 공유 프레임을 내보내면 여러 페이지가 한 슬롯을 가리키므로
+ * 참조 수를 셉니다. page 와 pml4 는 슬롯을 가리키는 페이지가 하나뿐일 때만 채워지며,
+ * swap-in 할 때 뒤따르는 슬롯이 같은 주소 공간의 것인지 확인하는 데 씁니다. */
+struct swap_slot {
+	int cnt;               /* 이 슬롯을 가리키는 페이지 수 */
+	struct page *page;     /* 유일한 페이지, 모르면 NULL */
+	uint64_t *pml4;        /* 그 페이지의 주소 공간 */
+	struct zswap_entry *zswap; /* 압축 풀에 있는 내용, 디스크에 있으면 NULL */
+};
+static struct swap_slot *swap_slots;
+
+/* 스왑 readahead. 폴트가 난 슬롯과 함께 읽는 슬롯 수(자기 자신 포함)를
+ * 미리 읽은 페이지가 실제로 쓰였는지에 따라 늘리고 줄인다. swap_lock 으로 보호. */
+static size_t ra_window = SWAP_CLUSTER_SIZE / 2;
+static size_t ra_last_slot = BITMAP_ERROR;  /* 마지막으로 폴트가 난 슬롯 */
+static uint64_t *ra_last_pml4;
+static long long ra_page_cnt;      /* 미리 읽은 페이지 수 */
+static long long ra_hit_cnt;       /* 미리 읽은 뒤 실제로 접근된 페이지 수 */
+static long long ra_miss_cnt;      /* 접근되지 않고 쫓겨나거나 해제된 페이지 수 */
+
+/* 압축 스왑 풀 (zswap).
+ * 쫓겨나는 anon 페이지는 슬롯을 받은 뒤 디스크에 쓰기 전에 먼저 압축해서 메모리의 풀에
+ * 넣습니다. 슬롯은 디스크 자리를 예약만 해 두고, 풀이 가득 차면 가장 오래된 사본부터
+ * 그 자리에 풀어서 씁니다. 잘 압축되지 않는 페이지나 풀에 넣을 메모리가 없을 때는
+ * 바로 디스크에 씁니다. swap_lock 으로 보호됩니다.
+ * 디스크로 내리는 사본은 swap_lock 을 잡은 채 풀에서 빼 두고, 락을 놓은 뒤에 씁니다.
+ * 쓰는 동안에도 슬롯은 그 사본을 가리키므로 swap-in 은 사본에서 읽고,
+ * 슬롯이 반납되어도 다 쓸 때까지는 다른 페이지에 주지 않습니다. */
+struct zswap_entry {
+	size_t idx;               /* 이 사본이 대신하는 스왑 슬롯 */
+	size_t len;               /* 압축된 크기 */
+	bool writeback;           /* 풀에서 빠져 디스크에 쓰는 중 */
+	struct list_elem elem;    /* zswap_lru 또는 디스크에 쓸 목록의 원소 */
+	uint8_t data[];           /* 압축된 내용 */
+};
+
+/* malloc() 이 블록 arena 에서 내주는 가장 큰 크기. 이보다 크면 페이지 하나를 통째로 쓰므로
+ * 압축해서 넣어도 메모리가 줄지 않는다. */
+#define ZSWAP_MAX_BLOCK 1024
+#define ZSWAP_MAX_LEN (ZSWAP_MAX_BLOCK - sizeof (struct zswap_entry))
+
+size_t vm_zswap_pages = SIZE_MAX;  /* 커널 명령줄 -zs, SIZE_MAX 이면 user pool 의 1/8 */
+static size_t zswap_limit;         /* 풀이 쓸 수 있는 바이트 수 */
+static size_t zswap_bytes;         /* 풀의 사본들이 차지하는 malloc 블록 크기의 합 */
+static struct list zswap_lru;      /* 오래된 사본부터 */
+static uint16_t zswap_table[LZ_TABLE_SIZE];  /* lz_compress() 작업 공간 */
+static uint8_t zswap_buf[ZSWAP_MAX_LEN];     /* 압축 결과를 잠시 두는 곳 */
+static void *zswap_bounce;         /* 사본을 풀어서 디스크에 쓸 때 쓰는 페이지 */
+static struct lock zswap_bounce_lock; /* zswap_bounce 를 보호하는 락 */
+
+static void swap_write(size_t idx, void *kvas[], size_t cnt);
+
+/* 압축 스왑 풀 통계 */
+static long long zswap_store_cnt;    /* 풀에 넣은 페이지 수 */
+static long long zswap_reject_cnt;   /* 잘 압축되지 않거나 메모리가 없어서 디스크로 보낸 페이지 수 */
+static long long zswap_orig_bytes;   /* 풀에 넣은 페이지의 원래 크기 합 */
+static long long zswap_comp_bytes;   /* 그 페이지들의 압축된 크기 합 */
+static long long zswap_hit_cnt;      /* 풀에서 풀어서 swap-in 한 페이지 수 */
+static long long zswap_miss_cnt;     /* 디스크에서 읽어야 했던 swap-in 수 */
+static long long zswap_writeback_cnt; /* 풀이 가득 차서 디스크로 내린 페이지 수 */
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
@@ -29,8 +111,217 @@ void vm_anon_init(void) {
     swap_disk = disk_get(1, 1);  // 1:1 - 스왑디스크
     // // 스왑 영역도 PGSIZE(4096바이트) 단위로 관리
     // 스왑 테이블이 필요 - bit_map으로 관리, 사용가능한 slot공간 찾을 수 있도록 설정
-    size_t swap_disk_size = disk_size(swap_disk) / 8; // swap disk에 들어갈 수 있는 페이지 개수 
+    size_t swap_disk_size = disk_size(swap_disk) / SECTORS_PER_PAGE; // swap disk에 들어갈 수 있는 페이지 개수 
     swap_table = bitmap_create(swap_disk_size);            // swap disk 크기만큼 동적 할당
+    swap_slots = calloc(swap_disk_size, sizeof *swap_slots);
+    if (swap_table == NULL || swap_slots == NULL)
+        PANIC("vm_anon_init: out of memory");
+    lock_init(&swap_lock);
+
+		list_init(&zswap_lru);
+		if (vm_zswap_pages == SIZE_MAX)
+			vm_zswap_pages = palloc_user_free_cnt() / 8;
+		zswap_limit = vm_zswap_pages * PGSIZE;
+		if (zswap_limit > 0)
+			zswap_bounce = palloc_get_page(PAL_ASSERT);
+		lock_init(&zswap_bounce_lock);
+}
+
+/* Prints swap I/O statistics. */
+/* 스왑 I/O 통계를 출력합니다. */
+void anon_print_stats(void) {
+		printf("VM: %lld pages swapped out in %lld writes, %lld pages swapped in\n",
+		       swap_out_cnt, swap_write_cnt, swap_in_cnt);
+		printf("VM: %lld clean pages evicted without rewriting swap\n", swap_clean_cnt);
+		printf("VM: %lld executable pages discarded, %lld reloaded from the file\n",
+		       discard_cnt, reload_cnt);
+		file_print_stats();
+		printf("VM: %lld pages read ahead from swap, %lld hits, %lld misses, window %zu\n",
+		       ra_page_cnt, ra_hit_cnt, ra_miss_cnt, ra_window);
+		printf("VM: compressed swap stored %lld pages (%lld%% of their size), rejected %lld\n",
+		       zswap_store_cnt,
+		       zswap_orig_bytes > 0 ? zswap_comp_bytes * 100 / zswap_orig_bytes : 0,
+		       zswap_reject_cnt);
+		printf("VM: compressed swap %lld hits, %lld misses, %lld pages written to disk, "
+		       "%lld disk writes avoided\n",
+		       zswap_hit_cnt, zswap_miss_cnt, zswap_writeback_cnt,
+		       zswap_store_cnt - zswap_writeback_cnt);
+}
+
+/* LEN 바이트로 압축된 사본이 차지하는 malloc 블록의 크기 */
+static size_t zswap_block_size(size_t len) {
+		size_t size = 16;
+
+		while (size < sizeof (struct zswap_entry) + len)
+			size *= 2;
+		return size;
+}
+
+/* swap_lock 을 잡은 상태에서 사본 ENTRY 를 풀에서 빼고 해제합니다. */
+static void zswap_free_locked(struct zswap_entry *entry) {
+		ASSERT(lock_held_by_current_thread(&swap_lock));
+
+		swap_slots[entry->idx].zswap = NULL;
+		list_remove(&entry->elem);
+		zswap_bytes -= zswap_block_size(entry->len);
+		free(entry);
+}
+
+/* swap_lock 을 잡은 상태에서 사본 ENTRY 를 KVA 로 풉니다. */
+static void zswap_load_locked(struct zswap_entry *entry, void *kva) {
+		ASSERT(lock_held_by_current_thread(&swap_lock));
+
+		if (!lz_decompress(entry->data, entry->len, kva, PGSIZE))
+			PANIC("compressed swap slot %zu is corrupt", entry->idx);
+}
+
+/* swap_lock 을 잡은 상태에서 가장 오래된 사본을 풀에서 빼서 디스크에 쓸 목록 EVICTED 에
+ * 넣습니다. 실제로 쓰는 것은 락을 놓은 뒤 zswap_writeback() 이 합니다.
+ * 풀이 비어 있으면 false 를 반환합니다. */
+static bool zswap_evict_locked(struct list *evicted) {
+		ASSERT(lock_held_by_current_thread(&swap_lock));
+
+		if (list_empty(&zswap_lru))
+			return false;
+		struct zswap_entry *entry = list_entry(list_pop_front(&zswap_lru), struct zswap_entry, elem);
+
+		// 슬롯은 계속 이 사본을 가리키므로 디스크에 다 쓸 때까지 swap-in 은 사본에서 읽는다
+		entry->writeback = true;
+		zswap_bytes -= zswap_block_size(entry->len);
+		list_push_back(evicted, &entry->elem);
+		return true;
+}
+
+/* zswap_evict_locked() 로 풀에서 뺀 사본들을 풀어서 자기 슬롯에 씁니다. swap_lock 을
+ * 잡지 않고 부르므로 디스크에 쓰는 동안 다른 프로세스의 swap-in 과 슬롯 반납이 기다리지 않습니다. */
+static void zswap_writeback(struct list *evicted) {
+		ASSERT(!lock_held_by_current_thread(&swap_lock));
+
+		while (!list_empty(evicted)) {
+			struct zswap_entry *entry = list_entry(list_pop_front(evicted), struct zswap_entry, elem);
+			size_t idx = entry->idx;
+
+			lock_acquire(&zswap_bounce_lock);
+			if (!lz_decompress(entry->data, entry->len, zswap_bounce, PGSIZE))
+				PANIC("compressed swap slot %zu is corrupt", idx);
+			swap_write(idx, &zswap_bounce, 1);
+			lock_release(&zswap_bounce_lock);
+
+			// 이제 디스크의 내용이 유효하다. 쓰는 동안 슬롯이 반납되었으면 여기서 비운다.
+			lock_acquire(&swap_lock);
+			struct swap_slot *slot = &swap_slots[idx];
+			ASSERT(slot->zswap == entry);
+			slot->zswap = NULL;
+			if (slot->cnt == 0)
+				bitmap_set(swap_table, idx, false);
+			zswap_writeback_cnt++;
+			lock_release(&swap_lock);
+			free(entry);
+		}
+}
+
+/* swap_lock 을 잡은 상태에서 KVA 의 내용을 압축해 슬롯 IDX 의 사본으로 풀에 넣습니다.
+ * 잘 압축되지 않거나 메모리가 없으면 false 를 반환하고, 이때는 호출자가 디스크에 씁니다.
+ * 자리를 만들려고 풀에서 뺀 사본은 EVICTED 에 넣으며, 호출자가 락을 놓은 뒤
+ * zswap_writeback() 으로 디스크에 씁니다. */
+static bool zswap_store_locked(size_t idx, const void *kva, struct list *evicted) {
+		ASSERT(lock_held_by_current_thread(&swap_lock));
+		ASSERT(swap_slots[idx].zswap == NULL);
+
+		if (zswap_limit == 0)
+			return false;
+		size_t len = lz_compress(kva, PGSIZE, zswap_buf, ZSWAP_MAX_LEN, zswap_table);
+		if (len == 0 || zswap_block_size(len) > zswap_limit) {
+			zswap_reject_cnt++;
+			return false;
+		}
+		// 풀이 가득 차면 오래된 사본부터 디스크로 내려서 자리를 만든다
+		while (zswap_bytes + zswap_block_size(len) > zswap_limit)
+			if (!zswap_evict_locked(evicted))
+				break;
+
+		struct zswap_entry *entry = malloc(sizeof *entry + len);
+		if (entry == NULL) {
+			zswap_reject_cnt++;
+			return false;
+		}
+		entry->idx = idx;
+		entry->len = len;
+		entry->writeback = false;
+		memcpy(entry->data, zswap_buf, len);
+		list_push_back(&zswap_lru, &entry->elem);
+		swap_slots[idx].zswap = entry;
+		zswap_bytes += zswap_block_size(len);
+		zswap_store_cnt++;
+		zswap_orig_bytes += PGSIZE;
+		zswap_comp_bytes += len;
+		return true;
+}
+
+/* swap_lock 을 잡은 상태에서 PAGE 가 가진 슬롯 IDX 의 참조를 놓습니다.
+ * 마지막 참조였으면 슬롯을 반납합니다. */
+static void swap_slot_put_locked(size_t idx, struct page *page) {
+		struct swap_slot *slot = &swap_slots[idx];
+
+		ASSERT(lock_held_by_current_thread(&swap_lock));
+		ASSERT(slot->cnt > 0);
+		if (slot->page == page)
+			slot->page = NULL;
+		if (--slot->cnt == 0) {
+			slot->page = NULL;
+			slot->pml4 = NULL;
+			// 디스크에 쓰는 중인 사본은 zswap_writeback() 이 다 쓴 뒤에 슬롯과 함께 비운다
+			if (slot->zswap != NULL && slot->zswap->writeback)
+				return;
+			if (slot->zswap != NULL)
+				zswap_free_locked(slot->zswap);
+			bitmap_set(swap_table, idx, false);
+		}
+}
+
+/* Record whether the read-ahead page PAGE was ACCESSED before it is
+ * evicted or destroyed, and grow or shrink the readahead window. Does
+ * nothing for pages that were not read ahead or were already counted. */
+/* readahead 로 들어온 PAGE 가 쫓겨나거나 해제되기 전에 접근되었는지(ACCESSED) 기록하고,
+ * 그에 따라 readahead 창을 늘리거나 줄입니다. 이미 기록된 페이지는 무시합니다. */
+void anon_readahead_settle(struct page *page, bool accessed) {
+		if (!page->anon.readahead)
+			return;
+		page->anon.readahead = false;
+
+		lock_acquire(&swap_lock);
+		if (accessed) {
+			ra_hit_cnt++;
+			if (ra_window < SWAP_CLUSTER_SIZE)
+				ra_window++;
+		} else {
+			ra_miss_cnt++;
+			if (ra_window > 1)
+				ra_window /= 2;
+		}
+		lock_release(&swap_lock);
+}
+
+/* 슬롯 IDX 부터 연속된 CNT 개의 슬롯을 KVAS[0..CNT-1] 로 한 번의 디스크 명령으로 읽는다. */
+static void swap_read(size_t idx, void *kvas[], size_t cnt) {
+		void *sectors[SWAP_CLUSTER_SIZE * SECTORS_PER_PAGE];
+
+		ASSERT(cnt > 0 && cnt <= SWAP_CLUSTER_SIZE);
+		for (size_t i = 0; i < cnt; i++)
+			for (size_t j = 0; j < SECTORS_PER_PAGE; j++)
+				sectors[i * SECTORS_PER_PAGE + j] = kvas[i] + DISK_SECTOR_SIZE * j;
+		disk_read_sectors(swap_disk, idx * SECTORS_PER_PAGE, sectors, cnt * SECTORS_PER_PAGE);
+}
+
+/* KVAS[0..CNT-1] 을 슬롯 IDX 부터 연속된 CNT 개의 슬롯에 한 번의 디스크 명령으로 쓴다. */
+static void swap_write(size_t idx, void *kvas[], size_t cnt) {
+		const void *sectors[SWAP_CLUSTER_SIZE * SECTORS_PER_PAGE];
+
+		ASSERT(cnt > 0 && cnt <= SWAP_CLUSTER_SIZE);
+		for (size_t i = 0; i < cnt; i++)
+			for (size_t j = 0; j < SECTORS_PER_PAGE; j++)
+				sectors[i * SECTORS_PER_PAGE + j] = kvas[i] + DISK_SECTOR_SIZE * j;
+		disk_write_sectors(swap_disk, idx * SECTORS_PER_PAGE, sectors, cnt * SECTORS_PER_PAGE);
 }
 
 /* Initialize the file mapping */
@@ -40,51 +331,293 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva) {
 
     struct anon_page *anon_page = &page->anon;
 		anon_page->swap_idx = -1;
+		anon_page->readahead = false;
+		anon_page->dirtied = false;
+		return true;
+}
+
+/* Returns true if the contents of PAGE are still exactly what its
+ * executable segment holds, so the page can be dropped on eviction and
+ * read back from the file instead of the swap disk. */
+/* PAGE 의 내용이 아직 실행 파일의 세그먼트와 똑같으면 true 를 반환합니다.
+ * 이런 페이지는 스왑에 쓰지 않고 버렸다가 다음 폴트에서 파일에서 다시 읽습니다. */
+bool anon_backed_by_file(struct page *page) {
+		return page->area != NULL && page->area->file != NULL
+		       && page->anon.swap_idx == -1 && !page->anon.dirtied;
+}
+
+/* FRAME 을 매핑한 모든 페이지가 실행 파일에서 다시 읽을 수 있는지 확인합니다. */
+static bool frame_backed_by_file(struct frame *frame) {
+		for (struct list_elem *e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e))
+			if (!anon_backed_by_file(list_entry(e, struct page, rmap_elem)))
+				return false;
+		return true;
 }
 
 /* Swap in the page by read contents from the swap disk. */
+/* 슬롯의 내용을 KVA 로 읽어옵니다. 바로 뒤의 슬롯들이 같은 주소 공간의 페이지라면
+ * 빈 프레임이 있는 만큼 한 번의 디스크 명령으로 함께 읽어서 미리 매핑해 둡니다 (readahead). */
 static bool anon_swap_in(struct page *page, void *kva) {
     struct anon_page *anon_page = &page->anon;
+		struct thread *curr = thread_current();
+		struct page *pages[SWAP_CLUSTER_SIZE];
+		struct frame *frames[SWAP_CLUSTER_SIZE];
+		void *kvas[SWAP_CLUSTER_SIZE];
+		size_t idx = anon_page->swap_idx;
+		size_t cnt = 1;
+
+		// 쫓겨날 때 버려진 페이지는 실행 파일에서 처음처럼 다시 읽는다
+		if (anon_page->swap_idx == -1) {
+			if (!anon_backed_by_file(page) || !lazy_load_segment(page, page->area))
+				return false;
+			reload_cnt++;
+			return true;
+		}
 		
 		if (bitmap_test(swap_table, anon_page->swap_idx) == false) // anon_page에 저장한 slot 정보를 통해 swap_disk에 내용가져오기
 			return false; 
-		
-		for (int i = 0; i < 8; ++i)
-		{
-			disk_read(swap_disk, anon_page->swap_idx * 8 + i, kva + DISK_SECTOR_SIZE * i); // 디스크 swap_disk 에서 섹터 SEC_NO를 읽어 BUFFER에 저장
+
+		pages[0] = page;
+		kvas[0] = kva;
+
+		// 압축 풀에 있으면 디스크를 읽지 않고 풀어 온다
+		lock_acquire(&swap_lock);
+		struct zswap_entry *entry = swap_slots[idx].zswap;
+		if (entry != NULL) {
+			zswap_load_locked(entry, kva);
+			// 슬롯을 혼자 쓰고 있으면 사본을 놓아서 풀을 비운다. 다시 쫓겨나면 새로 압축한다.
+			if (swap_slots[idx].cnt == 1) {
+				swap_slot_put_locked(idx, page);
+				anon_page->swap_idx = -1;
+			}
+			zswap_hit_cnt++;
+			swap_in_cnt++;
+			lock_release(&swap_lock);
+			return true;
 		}
+		if (zswap_limit > 0)
+			zswap_miss_cnt++;
 
-		bitmap_set(swap_table,anon_page->swap_idx,false);
-		
+		// 같은 주소 공간의 뒤따르는 슬롯을 창 크기만큼 모은다
+		if (ra_window == 1 && ra_last_pml4 == curr->pml4 && idx == ra_last_slot + 1)
+			ra_window = 2; // 창이 닫혀 있어도 순차 접근이 보이면 다시 열어 본다
+		ra_last_slot = idx;
+		ra_last_pml4 = curr->pml4;
+		// madvise 로 접근 패턴을 알려 준 영역은 적응형 창 대신 그 패턴을 따른다
+		size_t window = ra_window;
+		if (page->area != NULL && page->area->advice == VM_ADVICE_RANDOM)
+			window = 1;
+		else if (page->area != NULL && page->area->advice == VM_ADVICE_SEQUENTIAL)
+			window = SWAP_CLUSTER_SIZE;
+		for (; cnt < window && idx + cnt < bitmap_size(swap_table); cnt++) {
+			struct swap_slot *slot = &swap_slots[idx + cnt];
+			if (slot->page == NULL || slot->pml4 != curr->pml4 || slot->page->frame != NULL
+			    || slot->zswap != NULL)
+				break; // 다른 주소 공간(또는 공유)의 슬롯이거나 이미 메모리에 있는 페이지의 스왑 캐시, 또는 풀에 있는 슬롯
+			pages[cnt] = slot->page;
+		}
+		lock_release(&swap_lock);
+
+		// 미리 읽기에는 남는 프레임만 쓰고 다른 페이지를 쫓아내지 않는다
+		for (size_t i = 1; i < cnt; i++) {
+			frames[i] = vm_get_free_frame();
+			if (frames[i] == NULL) {
+				cnt = i;
+				break;
+			}
+			kvas[i] = frame_kva(frames[i]);
+		}
+
+		swap_read(idx, kvas, cnt); // 슬롯들의 섹터를 한 번에 읽어옴
+		swap_in_cnt += cnt;
+		ra_page_cnt += cnt - 1;
+
+		// 미리 읽은 페이지를 매핑한다. 매핑에 실패하면 그 페이지는 스왑에 그대로 둔다.
+		for (size_t i = 1; i < cnt; i++) {
+			vm_map_frame(frames[i], pages[i], curr->pml4);
+			if (!pml4_set_page(curr->pml4, pages[i]->va, kvas[i], pages[i]->writable)) {
+				vm_free_frame(pages[i]);
+				continue;
+			}
+			pages[i]->anon.readahead = true;
+			frames[i]->pinned = false;
+		}
+
+		// 슬롯은 반납하지 않는다 (스왑 캐시). 페이지가 수정되지 않은 채로 다시 쫓겨나면
+		// 디스크의 사본을 그대로 쓰고, 수정되었으면 그때 슬롯을 놓는다.
 		return true;
 
 }
 
+/* Read the swapped-out contents of PAGE into KVA, leaving the swap slot
+ * owned by PAGE. Used by fork to copy a page that is not resident. */
+/* 스왑 아웃된 PAGE 의 내용을 KVA 로 읽어옵니다. 슬롯은 PAGE 가 계속 소유합니다. */
+void anon_swap_copy(struct page *page, void *kva) {
+		struct anon_page *anon_page = &page->anon;
+
+		ASSERT(anon_page->swap_idx != -1);
+		lock_acquire(&swap_lock);
+		struct zswap_entry *entry = swap_slots[anon_page->swap_idx].zswap;
+		if (entry != NULL) {
+			zswap_load_locked(entry, kva);
+			lock_release(&swap_lock);
+			return;
+		}
+		lock_release(&swap_lock);
+		swap_read(anon_page->swap_idx, &kva, 1);
+}
+
 /* Swap out the page by writing contents to the swap disk. */
 static bool anon_swap_out(struct page *page) {
-    struct anon_page *anon_page = &page->anon;
-		// swap_disk, swap_table 에서 사용가능한 slot공간 찾기 - 추후 사용 slot의 bit -> true 으로 바꿔줘야 함
-		int slot_no = bitmap_scan(swap_table,0,1,false);  // 단일 페이지 
+		return anon_swap_out_cluster(&page, 1);
+}
 
-		if (slot_no == BITMAP_ERROR)
-			return false;
-		
-		for (int i = 0; i < 8; ++i) 
-		{	
-			// page->frame->kva의 데이터를 slot에 write // 어차피 매핑된 상태에서의 데이터를 쓰는 거니까 page->va 도 상관없을 듯
-			// 디스크의 섹터 SEC_NO에 BUFFER에 저장된 DISK_SECTOR_SIZE 바이트의 데이터를 쓰는 역할
-			disk_write(swap_disk, slot_no * 8 + i, page->va + DISK_SECTOR_SIZE * i);
+/* swap_lock 을 잡은 상태에서 연속된 빈 슬롯 CNT 개를 찾아 사용 중으로 표시합니다.
+ * 빈 슬롯이 없으면 메모리에 올라와 있는 페이지가 붙잡고 있는 스왑 캐시 슬롯을 모두
+ * 놓아준 뒤 한 번 더 찾습니다. 실패하면 BITMAP_ERROR 를 반환합니다. */
+static size_t swap_slot_alloc_locked(size_t cnt) {
+		ASSERT(lock_held_by_current_thread(&swap_lock));
+
+		size_t slot_no = bitmap_scan_and_flip(swap_table, 0, cnt, false);
+		if (slot_no != BITMAP_ERROR)
+			return slot_no;
 
+		for (size_t i = 0; i < bitmap_size(swap_table); i++) {
+			struct page *page = swap_slots[i].page;
+			// swap-in 중이거나 쫓겨나는 중인 프레임(pinned)의 슬롯은 건드리지 않는다
+			if (page != NULL && page->frame != NULL && !page->frame->pinned) {
+				page->anon.swap_idx = -1;
+				swap_slot_put_locked(i, page);
+			}
 		}
+		return bitmap_scan_and_flip(swap_table, 0, cnt, false);
+}
 
-		// 추후 사용 slot의 bit -> true 
-		bitmap_set(swap_table, slot_no, true);
-		// present bit 0으로 설정 - 물리 메모리와 매핑 해제
-		pml4_clear_page(thread_current()->pml4, page->va);
-		
+/* FRAME 의 내용과 같은 사본을 가진 스왑 슬롯. FRAME 을 매핑한 페이지들이 서로 다른
+ * 슬롯을 가리키거나 아무도 슬롯을 갖고 있지 않으면 -1. swap_lock 을 잡고 호출합니다. */
+static int frame_cached_slot(struct frame *frame) {
+		int slot = -1;
+
+		for (struct list_elem *e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+			int idx = list_entry(e, struct page, rmap_elem)->anon.swap_idx;
+			if (idx == -1)
+				continue;
+			if (slot != -1 && slot != idx)
+				return -1;
+			slot = idx;
+		}
+		return slot;
+}
+
+/* Swap out the frames of the CNT resident anonymous pages in PAGES,
+ * unmapping them from every address space that shares them. A frame that
+ * is still clean since it was swapped in keeps its old slot and is not
+ * written again (swap cache). The others are written, in order, to
+ * contiguous swap slots with a single disk transfer. Returns false, with
+ * every mapping restored, if there is no run of free slots. */
+/* 메모리에 있는 anon 페이지 CNT 개의 프레임을 내보냅니다. 프레임을 공유하는 모든
+ * 주소 공간에서 매핑을 끊고, 공유하던 페이지들은 같은 슬롯을 가리키게 됩니다.
+ * swap-in 된 뒤로 수정되지 않은 프레임은 디스크의 사본이 아직 유효하므로 다시 쓰지 않습니다 (스왑 캐시).
+ * 나머지는 연속된 스왑 슬롯에 순서대로, 한 번의 디스크 명령으로 씁니다.
+ * 함께 내보낸 페이지는 나중에 한 번에 다시 읽을 수 있습니다.
+ * 연속된 빈 슬롯이 없으면 매핑을 되돌리고 false 를 반환합니다. */
+bool anon_swap_out_cluster(struct page *pages[], size_t cnt) {
+		struct frame *dirty[SWAP_CLUSTER_SIZE];
+		bool was_dirty[SWAP_CLUSTER_SIZE];
+		void *kvas[SWAP_CLUSTER_SIZE];
+		size_t dirty_cnt = 0;
+		size_t discarded = 0;
+		struct list_elem *e;
+
+		ASSERT(cnt > 0 && cnt <= SWAP_CLUSTER_SIZE);
+		for (size_t i = 0; i < cnt; i++) {
+			struct frame *frame = pages[i]->frame;
+
+			frame->pinned = true; // 스왑 캐시 회수 대상에서 제외
+			anon_readahead_settle(pages[i], vm_frame_is_accessed(frame));
+			// 쓰는 도중에 프로세스가 페이지를 수정하지 못하도록 먼저 모든 매핑을 끊는다 (dirty 비트는 남는다)
+			// (victim 이 다른 프로세스의 페이지일 수 있으므로 rmap 의 pml4 와 kva 를 사용)
+			vm_frame_unmap_all(frame);
+			was_dirty[i] = vm_frame_is_dirty(frame);
+		}
+
+		lock_acquire(&swap_lock);
+		for (size_t i = 0; i < cnt; i++) {
+			struct frame *frame = pages[i]->frame;
+
+			// 실행 파일과 내용이 같으면 쓰지 않고 버린다. 모든 페이지의 swap_idx 는 -1 로 남는다.
+			if (!was_dirty[i] && frame_backed_by_file(frame)) {
+				discarded++;
+				continue;
+			}
+
+			int slot = was_dirty[i] ? -1 : frame_cached_slot(frame);
+
+			for (e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+				struct anon_page *anon_page = &list_entry(e, struct page, rmap_elem)->anon;
+				if (anon_page->swap_idx == slot)
+					continue;
+				if (anon_page->swap_idx != -1) // 내용이 바뀌었으므로 이전 사본은 버린다
+					swap_slot_put_locked(anon_page->swap_idx, list_entry(e, struct page, rmap_elem));
+				anon_page->swap_idx = slot;
+				if (slot != -1) {
+					swap_slots[slot].cnt++;
+					anon_page->dirtied = true;
+				}
+			}
+			if (slot != -1)
+				continue; // 디스크의 사본이 그대로 유효
+			kvas[dirty_cnt] = frame_kva(frame);
+			dirty[dirty_cnt++] = frame;
+		}
+
+		// swap_disk, swap_table 에서 사용가능한 연속된 slot공간 찾고 사용 중으로 표시
+		size_t slot_no = dirty_cnt > 0 ? swap_slot_alloc_locked(dirty_cnt) : 0;
+		if (slot_no == BITMAP_ERROR) {
+			// 만약 디스크에 슬롯이 없다면 매핑을 되돌리고 실패
+			lock_release(&swap_lock);
+			for (size_t i = 0; i < cnt; i++) {
+				vm_frame_remap_all(pages[i]->frame);
+				pages[i]->frame->pinned = false;
+			}
+			return false;
+		}
 		// page->anonpage에 사용한 slot의 정보(데이터의 위치)를 저장
-		anon_page->swap_idx = slot_no;
-		// 만약 디스크에 슬롯이 없다면 커널 패닉
+		bool stored[SWAP_CLUSTER_SIZE];
+		struct list evicted;
+		list_init(&evicted);
+		for (size_t i = 0; i < dirty_cnt; i++) {
+			struct swap_slot *slot = &swap_slots[slot_no + i];
+			struct page *page = frame_primary(dirty[i]);
+
+			slot->cnt = dirty[i]->ref_cnt;
+			slot->page = slot->cnt == 1 ? page : NULL;
+			slot->pml4 = slot->cnt == 1 ? page->pml4 : NULL;
+			for (e = list_begin(&dirty[i]->rmap); e != list_end(&dirty[i]->rmap); e = list_next(e)) {
+				struct anon_page *anon_page = &list_entry(e, struct page, rmap_elem)->anon;
+				anon_page->swap_idx = slot_no + i;
+				anon_page->dirtied = true; // 이제부터 실행 파일이 아니라 스왑이 이 페이지의 원본
+			}
+			// 먼저 압축 풀에 넣어 본다. 들어가면 디스크에는 쓰지 않는다.
+			stored[i] = zswap_store_locked(slot_no + i, kvas[i], &evicted);
+		}
+		lock_release(&swap_lock);
+		zswap_writeback(&evicted);
+
+		// 풀에 들어가지 못한 페이지를 연속된 슬롯끼리 묶어서 쓴다
+		for (size_t i = 0; i < dirty_cnt; ) {
+			size_t run = 0;
+			while (i + run < dirty_cnt && !stored[i + run])
+				run++;
+			if (run > 0) {
+				swap_write(slot_no + i, kvas + i, run);
+				swap_write_cnt++;
+			}
+			i += run > 0 ? run : 1;
+		}
+		swap_out_cnt += dirty_cnt;
+		swap_clean_cnt += cnt - dirty_cnt - discarded;
+		discard_cnt += discarded;
 		return true;
 }
 
@@ -92,8 +625,16 @@ static bool anon_swap_out(struct page *page) {
 static void anon_destroy(struct page *page) {
     struct anon_page *anon_page = &page->anon;
 		// anon의 자원들을 free , 페이지 구조체를 free할 필요없음
-    // if (page->frame->kva)
-    // {
-    // 	free(page->frame);
-    // }
+		if (page->frame != NULL) {
+			anon_readahead_settle(page, pml4_is_accessed(thread_current()->pml4, page->va));
+			pml4_clear_page(thread_current()->pml4, page->va);
+			vm_free_frame(page);
+		}
+		// 스왑 아웃된 상태이거나 스왑 캐시에 사본이 있다면 slot 반납
+		lock_acquire(&swap_lock);
+		if (anon_page->swap_idx != -1) {
+			swap_slot_put_locked(anon_page->swap_idx, page);
+			anon_page->swap_idx = -1;
+		}
+		lock_release(&swap_lock);
 }
@@ -0,0 +1,271 @@
+/* area.c: Regions (VMAs) of a process's address space.
+ *
+ * Each supplemental page table keeps its regions in an array sorted by start
+ * address, so finding the region that covers an address is a binary search.
+ * mmap, munmap and fork work on whole regions; the per-page struct page is
+ * only created when a page of the region is first touched. */
+
+/* area.c: 프로세스 주소 공간의 영역(VMA)들을 관리합니다.
+ * 영역은 시작 주소 순으로 정렬된 배열에 들어 있어 이진 탐색으로 찾습니다.
+ * mmap, munmap, fork 는 페이지 단위가 아니라 영역 단위로 일하고,
+ * struct page 는 그 페이지에 처음 접근할 때 만들어집니다. */
+
+#include "vm/area.h"
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+
+/* VA 보다 end 가 큰 첫 영역의 인덱스를 반환합니다. 없으면 area_cnt. */
+static size_t area_index(struct supplemental_page_table *spt, const void *va) {
+    size_t lo = 0, hi = spt->area_cnt;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (spt->areas[mid]->end <= va)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* AREA 를 정렬 순서를 지키며 IDX 자리에 끼워 넣습니다. */
+static bool area_insert_at(struct supplemental_page_table *spt, size_t idx, struct vm_area *area) {
+    if (spt->area_cnt == spt->area_cap) {
+        size_t cap = spt->area_cap ? spt->area_cap * 2 : 8;
+        struct vm_area **areas = realloc(spt->areas, cap * sizeof *areas);
+        if (areas == NULL)
+            return false;
+        spt->areas = areas;
+        spt->area_cap = cap;
+    }
+    memmove(&spt->areas[idx + 1], &spt->areas[idx], (spt->area_cnt - idx) * sizeof *spt->areas);
+    spt->areas[idx] = area;
+    spt->area_cnt++;
+    return true;
+}
+
+/* Find the region that contains VA. Returns NULL if there is none. */
+/* VA 를 포함하는 영역을 찾습니다. 없으면 NULL 을 반환합니다. */
+struct vm_area *spt_find_area(struct supplemental_page_table *spt, const void *va) {
+    size_t idx = area_index(spt, va);
+
+    if (idx < spt->area_cnt && spt->areas[idx]->start <= va)
+        return spt->areas[idx];
+    return NULL;
+}
+
+/* Returns true if [START, START + LENGTH) lies in user space and overlaps
+ * neither a region nor the stack. */
+/* [START, START + LENGTH) 가 사용자 주소 공간 안에 있고 다른 영역이나 스택과 겹치지 않으면
+ * true 를 반환합니다. */
+bool spt_range_is_free(struct supplemental_page_table *spt, const void *start, size_t length) {
+    const void *end = start + length;
+    size_t idx = area_index(spt, start);
+
+    if (end <= start || (uint64_t) end > KERN_BASE)
+        return false;
+    if (idx < spt->area_cnt && spt->areas[idx]->start < end)
+        return false;
+    // 스택 페이지는 영역 없이 spt 에 바로 들어가므로 스택 영역 전체를 예약해 둔다
+    if (start < (void *) USER_STACK && end > (void *) STACK_LIMIT)
+        return false;
+    return true;
+}
+
+/* Returns true if every page of [START, START + LENGTH) belongs to some
+ * region. START must be page-aligned and LENGTH non-zero. */
+/* [START, START + LENGTH) 의 모든 페이지가 어떤 영역에 속하면 true 를 반환합니다.
+ * START 는 페이지 경계여야 하고 LENGTH 는 0 이 아니어야 합니다. */
+bool spt_range_is_mapped(struct supplemental_page_table *spt, const void *start, size_t length) {
+    const void *end = start + length;
+
+    if (pg_ofs(start) != 0 || length == 0 || end <= start || !is_user_vaddr(end - 1))
+        return false;
+    for (const void *va = start; va < end; ) {
+        struct vm_area *area = spt_find_area(spt, va);
+        if (area == NULL)
+            return false;
+        va = area->end;
+    }
+    return true;
+}
+
+/* Returns the lowest page-aligned address at or above HINT where LENGTH
+ * bytes fit without overlapping a region or the stack, or NULL if there
+ * is none. */
+/* HINT 이상에서 LENGTH 바이트가 다른 영역이나 스택과 겹치지 않고 들어가는 가장 낮은
+ * 페이지 경계 주소를 반환합니다. 없으면 NULL 을 반환합니다. */
+void *spt_find_free_range(struct supplemental_page_table *spt, const void *hint, size_t length) {
+    void *start = pg_round_up(hint);
+
+    // start 와 겹치는 영역을 만날 때마다 그 영역 뒤로 후보를 옮긴다
+    for (size_t idx = area_index(spt, start);
+         idx < spt->area_cnt && spt->areas[idx]->start < start + length; idx++)
+        start = spt->areas[idx]->end;
+    return spt_range_is_free(spt, start, length) ? start : NULL;
+}
+
+/* Create a region of LENGTH bytes at the page-aligned address START. The
+ * first READ_BYTES bytes are read from FILE starting at OFFSET and the rest
+ * is zero-filled. On success the region takes ownership of FILE. Returns
+ * NULL if the range is already in use or memory is exhausted. */
+/* START 부터 LENGTH 바이트 크기의 영역을 만듭니다. 앞의 READ_BYTES 바이트는
+ * FILE 의 OFFSET 부터 읽고 나머지는 0 으로 채웁니다. 성공하면 FILE 은 영역이 소유합니다.
+ * 다른 영역과 겹치거나 메모리가 부족하면 NULL 을 반환합니다. */
+struct vm_area *vm_area_create(struct supplemental_page_table *spt, void *start, size_t length,
+                               enum vm_type type, bool writable, struct file *file,
+                               off_t offset, size_t read_bytes) {
+    ASSERT(pg_ofs(start) == 0);
+
+    length = (size_t) pg_round_up(length);
+    if (length == 0 || !spt_range_is_free(spt, start, length))
+        return NULL;
+
+    struct vm_area *area = malloc(sizeof *area);
+    if (area == NULL)
+        return NULL;
+    area->start = start;
+    area->end = start + length;
+    area->type = type;
+    area->writable = writable;
+    area->file = file;
+    area->offset = offset;
+    area->read_bytes = read_bytes;
+    area->advice = VM_ADVICE_NORMAL;
+    list_init(&area->pages);
+
+    if (!area_insert_at(spt, area_index(spt, start), area)) {
+        free(area);
+        return NULL;
+    }
+    return area;
+}
+
+/* 영역을 배열에서 빼지 않고 페이지와 파일만 정리한 뒤 해제합니다. */
+static void area_free(struct supplemental_page_table *spt, struct vm_area *area) {
+    // 만들어진 페이지를 먼저 없애야 dirty 한 파일 페이지가 area->file 에 기록된다
+    while (!list_empty(&area->pages)) {
+        struct page *page = list_entry(list_front(&area->pages), struct page, area_elem);
+        spt_remove_page(spt, page);
+    }
+    if (area->file != NULL)
+        file_close(area->file);
+    free(area);
+}
+
+/* Remove AREA and every page created inside it from SPT. */
+/* AREA 와 그 안에서 만들어진 모든 페이지를 SPT 에서 제거합니다. */
+void vm_area_destroy(struct supplemental_page_table *spt, struct vm_area *area) {
+    size_t idx = area_index(spt, area->start);
+
+    ASSERT(idx < spt->area_cnt && spt->areas[idx] == area);
+    memmove(&spt->areas[idx], &spt->areas[idx + 1], (spt->area_cnt - idx - 1) * sizeof *spt->areas);
+    spt->area_cnt--;
+    area_free(spt, area);
+}
+
+/* Change the size of AREA to LENGTH bytes, keeping its start. Growing
+ * fails if the pages after AREA are in use; shrinking removes the pages
+ * past the new end. */
+/* 시작 주소는 그대로 두고 AREA 의 크기를 LENGTH 바이트로 바꿉니다.
+ * 늘릴 때 뒤쪽이 사용 중이면 실패하고, 줄일 때는 새 끝 뒤의 페이지를 제거합니다. */
+bool vm_area_resize(struct supplemental_page_table *spt, struct vm_area *area, size_t length) {
+    void *end = area->start + (size_t) pg_round_up(length);
+
+    if (end <= area->start)
+        return false;
+    if (end > area->end) {
+        if (!spt_range_is_free(spt, area->end, end - area->end))
+            return false;
+    } else {
+        struct list_elem *e = list_begin(&area->pages);
+        while (e != list_end(&area->pages)) {
+            struct page *page = list_entry(e, struct page, area_elem);
+            e = list_next(e);
+            if (page->va >= end)
+                spt_remove_page(spt, page);
+        }
+    }
+    area->end = end;
+    if (area->read_bytes > (size_t) (end - area->start))
+        area->read_bytes = end - area->start;
+    return true;
+}
+
+/* Move AREA, with the pages created inside it, so that it starts at START.
+ * The destination must be free. Frames are not copied. */
+/* AREA 를 그 안의 페이지와 함께 START 에서 시작하도록 옮깁니다.
+ * 옮겨 갈 범위는 비어 있어야 하며 프레임 내용은 복사하지 않습니다. */
+bool vm_area_move(struct supplemental_page_table *spt, struct vm_area *area, void *start) {
+    size_t idx = area_index(spt, area->start);
+    size_t length = area->end - area->start;
+
+    ASSERT(idx < spt->area_cnt && spt->areas[idx] == area);
+    ASSERT(spt_range_is_free(spt, start, length));
+
+    if (!spt_move_pages(spt, &area->pages, start - area->start))
+        return false;
+    memmove(&spt->areas[idx], &spt->areas[idx + 1], (spt->area_cnt - idx - 1) * sizeof *spt->areas);
+    spt->area_cnt--;
+    area->start = start;
+    area->end = start + length;
+    // 방금 한 칸을 비웠으므로 다시 넣을 때는 realloc 이 일어나지 않는다
+    if (!area_insert_at(spt, area_index(spt, start), area))
+        NOT_REACHED();
+    return true;
+}
+
+/* Copy every region of SRC into the empty DST. Pages are not copied. */
+/* SRC 의 모든 영역을 비어 있는 DST 로 복사합니다. 페이지는 복사하지 않습니다. */
+bool spt_copy_areas(struct supplemental_page_table *dst, struct supplemental_page_table *src) {
+    ASSERT(dst->area_cnt == 0);
+
+    for (size_t i = 0; i < src->area_cnt; i++) {
+        struct vm_area *parent = src->areas[i];
+        struct file *file = NULL;
+
+        if (parent->file != NULL && (file = file_reopen(parent->file)) == NULL)
+            return false;
+        // src 가 정렬되어 있으므로 항상 끝에 붙이면 된다
+        struct vm_area *area = malloc(sizeof *area);
+        if (area == NULL || !area_insert_at(dst, dst->area_cnt, area)) {
+            free(area);
+            if (file != NULL)
+                file_close(file);
+            return false;
+        }
+        memcpy(area, parent, sizeof *area);
+        area->file = file;
+        list_init(&area->pages);
+    }
+    return true;
+}
+
+/* Free every region of SPT together with the pages created inside it. */
+/* SPT 의 모든 영역을 그 안에서 만들어진 페이지와 함께 해제합니다. */
+void spt_kill_areas(struct supplemental_page_table *spt) {
+    for (size_t i = 0; i < spt->area_cnt; i++)
+        area_free(spt, spt->areas[i]);
+    free(spt->areas);
+    spt->areas = NULL;
+    spt->area_cnt = spt->area_cap = 0;
+}
+
+/* File offset that backs the page at UPAGE inside AREA. */
+/* AREA 안의 UPAGE 에 대응하는 파일 오프셋 */
+off_t vm_area_page_offset(struct vm_area *area, const void *upage) {
+    return area->offset + (upage - area->start);
+}
+
+/* Number of bytes of the page at UPAGE inside AREA that come from the file.
+ * The rest of the page is zero. */
+/* AREA 안의 UPAGE 에서 파일로부터 읽어야 하는 바이트 수. 나머지는 0 입니다. */
+size_t vm_area_page_read_bytes(struct vm_area *area, const void *upage) {
+    size_t page_ofs = upage - area->start;
+
+    if (area->file == NULL || area->read_bytes <= page_ofs)
+        return 0;
+    return area->read_bytes - page_ofs < PGSIZE ? area->read_bytes - page_ofs : PGSIZE;
+}
@@ -1,6 +1,11 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
+#include <string.h>
+#include <stdio.h>
 #include "vm/vm.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
 #include "threads/mmu.h"
@@ -9,6 +14,74 @@ static bool file_backed_swap_in(struct page *page, void *kva);
 static bool file_backed_swap_out(struct page *page);
 static void file_backed_destroy(struct page *page);
 
+/* 비동기 writeback.
+ * 수정된 mmap 페이지는 내용을 커널 페이지에 복사해서 큐에 넣으므로, 쫓아내거나
+ * munmap 하는 스레드는 디스크에 쓰기를 기다리지 않고 프레임은 바로 깨끗해집니다.
+ * writeback 스레드는 큐를 (inode, 오프셋) 순으로 정렬하고 같은 파일에서 이어지는
+ * 페이지들을 한 번의 쓰기로 묶습니다. 파일을 읽거나 쓰기 전에는 vm_writeback_wait() 로
+ * 그 파일의 대기 중인 writeback 이 끝나기를 기다립니다. */
+#define WB_MAX_PENDING 64   /* 큐에 쌓아 둘 수 있는 페이지 수, 가득 차면 빌 때까지 기다림 */
+#define WB_MAX_RUN 8        /* 한 번의 쓰기로 묶는 최대 페이지 수 */
+
+struct wb_entry {
+    struct inode *inode;    /* 기록할 파일, 참조를 하나 갖고 있음 */
+    off_t ofs;              /* 파일 오프셋 */
+    size_t bytes;           /* 기록할 바이트 수 */
+    void *buf;              /* 페이지 내용의 사본 (커널 풀의 한 페이지) */
+    struct list_elem elem;
+};
+
+static struct list wb_queue;       /* 아직 쓰기 시작하지 않은 항목 */
+static struct list wb_inflight;    /* writeback 스레드가 지금 쓰고 있는 항목 */
+static size_t wb_pending;          /* 두 리스트의 항목 수 */
+static struct lock wb_lock;
+static struct condition wb_work;   /* 큐에 항목이 들어옴 */
+static struct condition wb_done;   /* 항목이 기록되어 빠짐 */
+static struct thread *wb_thread;
+
+/* writeback 통계 */
+static long long wb_page_cnt;      /* writeback 스레드가 기록한 페이지 수 */
+static long long wb_write_cnt;     /* 그때 쓴 file 쓰기 횟수 */
+static long long wb_sync_cnt;      /* 메모리가 부족해서 바로 기록한 페이지 수 */
+static long long wb_skip_cnt;      /* 큐가 가득 차서 쫓아내지 않고 건너뛴 페이지 수 */
+
+/* 미리 읽기 (readahead).
+ * 파일 페이지의 내용을 프레임에 올리기 전에 커널 페이지에 읽어 두는 작은 캐시입니다.
+ * MADV_WILLNEED 는 읽을 페이지를 큐에 넣고 바로 돌아오며, readahead 스레드가 같은 파일에서
+ * 이어지는 페이지들을 한 번의 읽기로 가져옵니다. 페이지를 올릴 때는 vm_file_read_page() 가
+ * 캐시를 먼저 보고, 있으면 복사한 뒤 항목을 버립니다. 파일의 내용이 바뀌면
+ * (쓰기, writeback 을 큐에 넣음, 삭제) 겹치는 항목을 버립니다. */
+#define RA_MAX_PAGES 32     /* 캐시에 둘 수 있는 페이지 수, 가득 차면 오래된 항목부터 버림 */
+
+enum ra_state {
+    RA_QUEUED,              /* readahead 스레드가 읽기를 기다림 */
+    RA_READING,             /* 읽는 중 */
+    RA_READY,               /* 읽어 둠, buf 에 내용이 있음 */
+};
+
+struct ra_entry {
+    struct inode *inode;    /* 읽을 파일, 참조를 하나 갖고 있음 */
+    off_t ofs;              /* 파일 오프셋 (페이지 경계) */
+    size_t bytes;           /* 읽을 바이트 수 */
+    void *buf;              /* 읽은 내용 (커널 풀의 한 페이지), 읽기 전에는 NULL */
+    enum ra_state state;
+    bool stale;             /* 읽는 도중 파일이 바뀌었으므로 읽은 뒤 버린다 */
+    struct list_elem elem;
+};
+
+static struct list ra_list;        /* 모든 항목, 먼저 들어온 것이 앞 */
+static size_t ra_cnt;              /* ra_list 의 항목 수 */
+static struct lock ra_lock;
+static struct condition ra_work;   /* 읽을 항목이 들어옴 */
+
+/* readahead 통계 */
+static long long ra_page_cnt;      /* 미리 읽은 페이지 수 */
+static long long ra_read_cnt;      /* 그때 쓴 읽기 횟수 */
+static long long ra_hit_cnt;       /* 미리 읽은 내용으로 올린 페이지 수 */
+
+static void writeback_worker(void *aux);
+static void readahead_worker(void *aux);
+
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
     .swap_in = file_backed_swap_in,
@@ -20,6 +93,439 @@ static const struct page_operations file_ops = {
 /* The initializer of file vm */
 /* 파일 지원 페이지 하위 시스템을 초기화 */
 void vm_file_init(void) {
+    list_init(&wb_queue);
+    list_init(&wb_inflight);
+    lock_init(&wb_lock);
+    cond_init(&wb_work);
+    cond_init(&wb_done);
+    if (thread_create("writeback", PRI_DEFAULT, writeback_worker, NULL) == TID_ERROR)
+        PANIC("vm_file_init: cannot start writeback thread");
+    list_init(&ra_list);
+    lock_init(&ra_lock);
+    cond_init(&ra_work);
+    if (thread_create("readahead", PRI_DEFAULT, readahead_worker, NULL) == TID_ERROR)
+        PANIC("vm_file_init: cannot start readahead thread");
+}
+
+/* Prints mmap writeback and readahead statistics. */
+/* mmap writeback 과 readahead 통계를 출력합니다. */
+void file_print_stats(void) {
+    printf("VM: %lld mmap pages written back in %lld writes, %lld written synchronously, "
+           "%lld evictions skipped\n", wb_page_cnt, wb_write_cnt, wb_sync_cnt, wb_skip_cnt);
+    printf("VM: %lld file pages read ahead in %lld reads, %lld used\n",
+           ra_page_cnt, ra_read_cnt, ra_hit_cnt);
+}
+
+/* wb_lock 을 잡은 상태에서 INODE 에 대한 항목이 아직 기록되지 않았는지 확인합니다.
+ * INODE 가 NULL 이면 어떤 항목이든 남아 있는지 확인합니다. */
+static bool writeback_pending(struct inode *inode) {
+    struct list *lists[] = { &wb_queue, &wb_inflight };
+
+    if (inode == NULL)
+        return wb_pending > 0;
+    for (size_t i = 0; i < 2; i++)
+        for (struct list_elem *e = list_begin(lists[i]); e != list_end(lists[i]); e = list_next(e))
+            if (list_entry(e, struct wb_entry, elem)->inode == inode)
+                return true;
+    return false;
+}
+
+/* Wait until every queued writeback of INODE has reached the disk, or of
+ * every file if INODE is null. Called before a file is read or written so
+ * that it never sees older data than its mmap pages. */
+/* INODE 에 대해 큐에 들어간 writeback 이 모두 디스크에 기록될 때까지 기다립니다.
+ * INODE 가 NULL 이면 모든 파일에 대해 기다립니다. 파일을 읽거나 쓰기 전에 호출해서
+ * mmap 페이지보다 오래된 내용을 보지 않게 합니다. */
+void vm_writeback_wait(struct inode *inode) {
+    // 대기 중인 항목이 없으면 락도 잡지 않는다. writeback 스레드 자신의 쓰기는 기다리지 않는다.
+    if (wb_pending == 0 || thread_current() == wb_thread)
+        return;
+
+    lock_acquire(&wb_lock);
+    while (writeback_pending(inode))
+        cond_wait(&wb_done, &wb_lock);
+    lock_release(&wb_lock);
+}
+
+/* 큐에 넣을 항목과 사본을 둘 커널 페이지를 받습니다. WAIT 이면 큐에 자리가 날 때까지
+ * 기다리고, 아니면 큐가 가득 차 있을 때 바로 NULL 을 반환합니다. 메모리가 없어도 NULL 입니다. */
+static struct wb_entry *writeback_alloc(bool wait) {
+    lock_acquire(&wb_lock);
+    while (wb_pending >= WB_MAX_PENDING) {
+        if (!wait) {
+            lock_release(&wb_lock);
+            return NULL;
+        }
+        cond_wait(&wb_done, &wb_lock);
+    }
+    lock_release(&wb_lock);
+
+    struct wb_entry *entry = malloc(sizeof *entry);
+    void *buf = palloc_get_page(0);
+    if (entry == NULL || buf == NULL) {
+        free(entry);
+        if (buf != NULL)
+            palloc_free_page(buf);
+        return NULL;
+    }
+    entry->buf = buf;
+    return entry;
+}
+
+/* writeback_alloc() 으로 받은 ENTRY 에 KVA 의 앞 BYTES 바이트를 복사해서
+ * FILE 의 OFS 에 기록하도록 큐에 넣습니다. */
+static void writeback_queue(struct wb_entry *entry, struct file *file, const void *kva,
+                            size_t bytes, off_t ofs) {
+    struct inode *inode = file_get_inode(file);
+
+    memcpy(entry->buf, kva, bytes);
+    entry->inode = inode_reopen(inode);
+    entry->ofs = ofs;
+    entry->bytes = bytes;
+
+    lock_acquire(&wb_lock);
+    list_push_back(&wb_queue, &entry->elem);
+    wb_pending++;
+    cond_signal(&wb_work, &wb_lock);
+    lock_release(&wb_lock);
+
+    // 이제부터 파일을 읽으면 이 사본이 기록되기를 기다리므로 미리 읽어 둔 내용은 낡았다
+    vm_readahead_forget(inode, ofs, bytes);
+}
+
+/* Queue the first BYTES bytes of KVA to be written to FILE at OFS by the
+ * writeback thread. The data is copied, so the caller may reuse KVA as soon
+ * as this returns. May wait for the queue or the disk, so it must not be
+ * called with frame_lock held. */
+/* KVA 의 앞 BYTES 바이트를 FILE 의 OFS 에 기록하도록 writeback 스레드에 넘깁니다.
+ * 내용은 복사되므로 호출자는 돌아오자마자 KVA 를 다시 써도 됩니다.
+ * 큐가 가득 차 있으면 빌 때까지 기다리고, 사본을 둘 메모리가 없으면 바로 씁니다.
+ * 기다릴 수 있으므로 frame_lock 을 잡은 채로 부르면 안 됩니다. */
+static void writeback_page(struct file *file, const void *kva, size_t bytes, off_t ofs) {
+    if (bytes == 0)
+        return;
+
+    struct wb_entry *entry = writeback_alloc(true);
+    if (entry == NULL) {
+        // 먼저 들어간 같은 파일의 항목보다 나중에 기록되어야 한다
+        vm_writeback_wait(file_get_inode(file));
+        file_write_at(file, kva, bytes, ofs);
+        wb_sync_cnt++;
+        return;
+    }
+    writeback_queue(entry, file, kva, bytes, ofs);
+}
+
+static bool wb_less(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED) {
+    const struct wb_entry *a = list_entry(a_, struct wb_entry, elem);
+    const struct wb_entry *b = list_entry(b_, struct wb_entry, elem);
+
+    if (a->inode != b->inode)
+        return a->inode < b->inode;
+    return a->ofs < b->ofs;
+}
+
+/* 정렬된 wb_inflight 의 E 부터 같은 파일에서 이어지는 항목들을 한 번에 기록하고
+ * 다음에 기록할 항목을 반환합니다. */
+static struct list_elem *writeback_run(struct list_elem *e) {
+    struct wb_entry *run[WB_MAX_RUN];
+    size_t cnt = 0, bytes = 0;
+
+    for (; e != list_end(&wb_inflight) && cnt < WB_MAX_RUN; e = list_next(e)) {
+        struct wb_entry *entry = list_entry(e, struct wb_entry, elem);
+        struct list_elem *next = list_next(e);
+
+        // 같은 위치를 나중에 다시 내보낸 항목이 바로 뒤에 있으면 (정렬이 안정적이므로) 이 사본은 낡았다
+        if (next != list_end(&wb_inflight)) {
+            struct wb_entry *newer = list_entry(next, struct wb_entry, elem);
+            if (newer->inode == entry->inode && newer->ofs == entry->ofs)
+                continue;
+        }
+        if (cnt > 0 && (entry->inode != run[0]->inode || entry->ofs != run[0]->ofs + (off_t) bytes
+                        || run[cnt - 1]->bytes != PGSIZE))
+            break;
+        run[cnt++] = entry;
+        bytes += entry->bytes;
+    }
+    if (cnt == 0)
+        return e;
+
+    // 여러 페이지는 연속된 버퍼에 모아서 한 번에 쓴다. 버퍼를 못 받으면 한 페이지씩 쓴다.
+    void *buf = cnt > 1 ? palloc_get_multiple(0, cnt) : NULL;
+    if (buf != NULL) {
+        for (size_t i = 0; i < cnt; i++)
+            memcpy(buf + i * PGSIZE, run[i]->buf, run[i]->bytes);
+        inode_write_at(run[0]->inode, buf, bytes, run[0]->ofs);
+        palloc_free_multiple(buf, cnt);
+        wb_write_cnt++;
+    } else {
+        for (size_t i = 0; i < cnt; i++)
+            inode_write_at(run[i]->inode, run[i]->buf, run[i]->bytes, run[i]->ofs);
+        wb_write_cnt += cnt;
+    }
+    wb_page_cnt += cnt;
+    return e;
+}
+
+/* writeback 스레드. 큐에 쌓인 항목을 한꺼번에 가져와 정렬하고 이어지는 것끼리 묶어서 기록합니다. */
+static void writeback_worker(void *aux UNUSED) {
+    wb_thread = thread_current();
+
+    for (;;) {
+        struct list done;
+
+        lock_acquire(&wb_lock);
+        while (list_empty(&wb_queue))
+            cond_wait(&wb_work, &wb_lock);
+        while (!list_empty(&wb_queue))
+            list_push_back(&wb_inflight, list_pop_front(&wb_queue));
+        // list_sort 는 안정적이므로 같은 위치의 항목은 먼저 들어온 것이 앞에 남는다
+        list_sort(&wb_inflight, wb_less, NULL);
+        lock_release(&wb_lock);
+
+        // 기다리는 스레드들도 wb_inflight 를 읽기만 하므로 락 없이 순회해도 된다
+        for (struct list_elem *e = list_begin(&wb_inflight); e != list_end(&wb_inflight); )
+            e = writeback_run(e);
+
+        list_init(&done);
+        lock_acquire(&wb_lock);
+        while (!list_empty(&wb_inflight)) {
+            list_push_back(&done, list_pop_front(&wb_inflight));
+            wb_pending--;
+        }
+        cond_broadcast(&wb_done, &wb_lock);
+        lock_release(&wb_lock);
+
+        while (!list_empty(&done)) {
+            struct wb_entry *entry = list_entry(list_pop_front(&done), struct wb_entry, elem);
+            inode_close(entry->inode);
+            palloc_free_page(entry->buf);
+            free(entry);
+        }
+    }
+}
+
+static void ra_free(struct ra_entry *entry) {
+    inode_close(entry->inode);
+    if (entry->buf != NULL)
+        palloc_free_page(entry->buf);
+    free(entry);
+}
+
+static void ra_free_list(struct list *entries) {
+    while (!list_empty(entries))
+        ra_free(list_entry(list_pop_front(entries), struct ra_entry, elem));
+}
+
+/* ra_lock 을 잡은 상태에서 (INODE, OFS) 에 대한 아직 쓸 수 있는 항목을 찾습니다. */
+static struct ra_entry *ra_find(struct inode *inode, off_t ofs) {
+    for (struct list_elem *e = list_begin(&ra_list); e != list_end(&ra_list); e = list_next(e)) {
+        struct ra_entry *entry = list_entry(e, struct ra_entry, elem);
+        if (entry->inode == inode && entry->ofs == ofs && !entry->stale)
+            return entry;
+    }
+    return NULL;
+}
+
+/* ra_lock 을 잡은 상태에서 (INODE, OFS) 의 BYTES 바이트를 읽을 항목을 STATE 로 만들어
+ * 넣습니다. 캐시가 가득 차면 가장 오래된 읽어 둔 항목을 DROPPED 로 옮겨서 자리를 만들고,
+ * 버릴 항목이 없거나 메모리가 없으면 NULL 을 반환합니다. */
+static struct ra_entry *ra_insert(struct inode *inode, off_t ofs, size_t bytes,
+                                  enum ra_state state, struct list *dropped) {
+    if (ra_cnt >= RA_MAX_PAGES) {
+        struct list_elem *e;
+        for (e = list_begin(&ra_list); e != list_end(&ra_list); e = list_next(e))
+            if (list_entry(e, struct ra_entry, elem)->state == RA_READY)
+                break;
+        if (e == list_end(&ra_list))
+            return NULL;
+        list_remove(e);
+        list_push_back(dropped, e);
+        ra_cnt--;
+    }
+
+    struct ra_entry *entry = malloc(sizeof *entry);
+    if (entry == NULL)
+        return NULL;
+    entry->inode = inode_reopen(inode);
+    entry->ofs = ofs;
+    entry->bytes = bytes;
+    entry->buf = NULL;
+    entry->state = state;
+    entry->stale = false;
+    list_push_back(&ra_list, &entry->elem);
+    ra_cnt++;
+    return entry;
+}
+
+/* 같은 파일에서 이어지는 CNT 개의 항목 RUN (모두 RA_READING) 을 연속된 커널 페이지에
+ * 한 번에 읽고 페이지를 항목들에 나눠 줍니다. 연속된 페이지를 받지 못하거나 읽기에
+ * 실패하거나 읽는 도중 파일이 바뀐 항목은 버립니다. ra_lock 없이 호출합니다. */
+static void readahead_run(struct ra_entry *run[], size_t cnt) {
+    size_t bytes = (cnt - 1) * PGSIZE + run[cnt - 1]->bytes;
+    void *buf = palloc_get_multiple(0, cnt);
+    bool ok = buf != NULL && inode_read_at(run[0]->inode, buf, bytes, run[0]->ofs) == (off_t) bytes;
+    struct list dropped;
+
+    list_init(&dropped);
+    lock_acquire(&ra_lock);
+    for (size_t i = 0; i < cnt; i++) {
+        if (buf != NULL)
+            run[i]->buf = buf + i * PGSIZE;
+        if (ok && !run[i]->stale) {
+            run[i]->state = RA_READY;
+        } else {
+            list_remove(&run[i]->elem);
+            list_push_back(&dropped, &run[i]->elem);
+            ra_cnt--;
+        }
+    }
+    if (ok) {
+        ra_page_cnt += cnt;
+        ra_read_cnt++;
+    }
+    lock_release(&ra_lock);
+    ra_free_list(&dropped);
+}
+
+/* Read the BYTES bytes of FILE at OFS, the contents of consecutive pages,
+ * into the readahead cache. OFS must be page-aligned. If SYNC is true the
+ * data is read before this returns; otherwise it is queued for the
+ * readahead thread and this does not wait for the disk. Pages already
+ * cached, or that do not fit, are skipped. */
+/* FILE 의 OFS 부터 BYTES 바이트 (이어지는 페이지들의 내용) 를 readahead 캐시에 읽어 둡니다.
+ * OFS 는 페이지 경계여야 합니다. SYNC 이면 돌아오기 전에 읽고, 아니면 readahead 스레드에
+ * 맡기고 디스크를 기다리지 않습니다. 이미 캐시에 있거나 자리가 없는 페이지는 건너뜁니다. */
+void vm_readahead(struct file *file, off_t ofs, size_t bytes, bool sync) {
+    struct inode *inode = file_get_inode(file);
+
+    ASSERT(ofs % PGSIZE == 0);
+    while (bytes > 0) {
+        struct ra_entry *run[VM_READAHEAD_BATCH];
+        size_t cnt = 0;
+        struct list dropped;
+
+        list_init(&dropped);
+        lock_acquire(&ra_lock);
+        while (bytes > 0 && cnt < VM_READAHEAD_BATCH) {
+            size_t page_bytes = bytes < PGSIZE ? bytes : PGSIZE;
+            if (ra_find(inode, ofs) == NULL) {
+                struct ra_entry *entry = ra_insert(inode, ofs, page_bytes,
+                                                   sync ? RA_READING : RA_QUEUED, &dropped);
+                if (entry == NULL) {
+                    bytes = 0; // 자리가 없다, 나머지는 폴트에서 읽는다
+                    break;
+                }
+                run[cnt++] = entry;
+            } else if (cnt > 0) {
+                break; // 이미 있는 페이지에서 묶음을 끊는다
+            }
+            ofs += PGSIZE;
+            bytes -= page_bytes;
+        }
+        if (!sync && cnt > 0)
+            cond_signal(&ra_work, &ra_lock);
+        lock_release(&ra_lock);
+        ra_free_list(&dropped);
+
+        if (sync && cnt > 0)
+            readahead_run(run, cnt);
+    }
+}
+
+/* readahead 스레드. 큐에 들어온 항목 중 가장 먼저 들어온 것부터 같은 파일에서 이어지는
+ * 항목들을 묶어서 한 번에 읽습니다. vm_readahead() 는 한 번의 호출로 넣는 항목들을 락을
+ * 잡은 채 차례로 넣으므로 이어지는 항목은 리스트에서도 붙어 있습니다. */
+static void readahead_worker(void *aux UNUSED) {
+    for (;;) {
+        struct ra_entry *run[VM_READAHEAD_BATCH];
+        size_t cnt = 0;
+        struct list_elem *e;
+
+        lock_acquire(&ra_lock);
+        for (;;) {
+            for (e = list_begin(&ra_list); e != list_end(&ra_list); e = list_next(e))
+                if (list_entry(e, struct ra_entry, elem)->state == RA_QUEUED)
+                    break;
+            if (e != list_end(&ra_list))
+                break;
+            cond_wait(&ra_work, &ra_lock);
+        }
+        for (; e != list_end(&ra_list) && cnt < VM_READAHEAD_BATCH; e = list_next(e)) {
+            struct ra_entry *entry = list_entry(e, struct ra_entry, elem);
+            if (entry->state != RA_QUEUED
+                || (cnt > 0 && (entry->inode != run[0]->inode || entry->ofs != run[0]->ofs + (off_t) (cnt * PGSIZE)
+                                || run[cnt - 1]->bytes != PGSIZE)))
+                break;
+            entry->state = RA_READING;
+            run[cnt++] = entry;
+        }
+        lock_release(&ra_lock);
+
+        readahead_run(run, cnt);
+    }
+}
+
+/* ra_lock 을 잡지 않고 INODE 의 OFS 에 대한 읽어 둔 항목을 꺼내 BYTES 바이트를 KVA 로 복사합니다. */
+static bool readahead_take(struct inode *inode, void *kva, size_t bytes, off_t ofs) {
+    // 캐시가 비어 있으면 락도 잡지 않는다
+    if (ra_cnt == 0)
+        return false;
+
+    lock_acquire(&ra_lock);
+    struct ra_entry *entry = ra_find(inode, ofs);
+    if (entry == NULL || entry->state != RA_READY || entry->bytes < bytes) {
+        lock_release(&ra_lock);
+        return false;
+    }
+    list_remove(&entry->elem);
+    ra_cnt--;
+    ra_hit_cnt++;
+    lock_release(&ra_lock);
+
+    memcpy(kva, entry->buf, bytes);
+    ra_free(entry);
+    return true;
+}
+
+/* Read the BYTES bytes of FILE at OFS that back one page into KVA, taking
+ * them from the readahead cache if they were read ahead. Returns the
+ * number of bytes read. */
+/* 한 페이지에 들어갈 FILE 의 OFS 부터 BYTES 바이트를 KVA 로 읽습니다. 미리 읽어 둔 내용이
+ * 있으면 디스크를 읽지 않고 그것을 씁니다. 읽은 바이트 수를 반환합니다. */
+off_t vm_file_read_page(struct file *file, void *kva, size_t bytes, off_t ofs) {
+    if (readahead_take(file_get_inode(file), kva, bytes, ofs))
+        return bytes;
+    return file_read_at(file, kva, bytes, ofs);
+}
+
+/* Drop the read-ahead data of INODE that overlaps [OFS, OFS + SIZE).
+ * Called whenever that part of the file changes. */
+/* INODE 의 [OFS, OFS + SIZE) 와 겹치는 미리 읽은 내용을 버립니다. 파일의 그 부분이
+ * 바뀔 때마다 호출합니다. 읽는 중인 항목은 읽기가 끝난 뒤 버려집니다. */
+void vm_readahead_forget(struct inode *inode, off_t ofs, off_t size) {
+    struct list dropped;
+
+    if (ra_cnt == 0 || size <= 0)
+        return;
+
+    list_init(&dropped);
+    lock_acquire(&ra_lock);
+    for (struct list_elem *e = list_begin(&ra_list); e != list_end(&ra_list); ) {
+        struct ra_entry *entry = list_entry(e, struct ra_entry, elem);
+        e = list_next(e);
+        if (entry->inode != inode || entry->ofs >= ofs + size || ofs >= entry->ofs + PGSIZE)
+            continue;
+        if (entry->state == RA_READY) {
+            list_remove(&entry->elem);
+            list_push_back(&dropped, &entry->elem);
+            ra_cnt--;
+        } else {
+            entry->stale = true;
+        }
+    }
+    lock_release(&ra_lock);
+    ra_free_list(&dropped);
 }
 
 /* Initialize the file backed page */
@@ -28,117 +534,160 @@ bool file_backed_initializer(struct page *page, enum vm_type type, void *kva) {
     page->operations = &file_ops;
 
     struct file_page *file_page = &page->file;
+    struct vm_area *area = page->area;
+
+    // 파일 페이지는 항상 mmap 영역 안에서 만들어진다
+    ASSERT(area != NULL && area->file != NULL);
+    file_page->ofs = vm_area_page_offset(area, page->va);
+    file_page->read_bytes = vm_area_page_read_bytes(area, page->va);
+    return true;
 }
 
 /* Swap in the page by read contents from the file. */
 static bool file_backed_swap_in(struct page *page, void *kva) {
-    struct file_page *file_page UNUSED = &page->file;
-    // 파일에서 콘텐츠를 읽어(read 함수 사용 ? ) kva 페이지에서 swap in합니다. 파일 시스템과 동기화해야 합니다.
-    // file_read_at() 를 사용해서 kva 에 페이지를 올림
-    struct aux *aux = (struct aux *)page->uninit.aux;  
-
-    file_seek(aux->file,aux->ofs);
-    off_t read_bytes = file_read(aux->file, kva , aux->page_read_bytes); // 읽은 바이트 수를 반환
-    
-    if ((int)read_bytes != (int)aux->page_read_bytes)
+    struct file_page *file_page = &page->file;
+    // 파일에서 콘텐츠를 읽어 kva 페이지에서 swap in합니다.
+    if (vm_file_read_page(page->area->file, kva, file_page->read_bytes, file_page->ofs) != (int)file_page->read_bytes)
         return false;
 
-    memset(kva + aux->page_read_bytes, 0, aux->page_zero_bytes); 
-
+    memset(kva + file_page->read_bytes, 0, PGSIZE - file_page->read_bytes);
     return true;
 }
 
-/* Swap out the page by writeback contents to the file. */
+/* Swap out the page by writeback contents to the file. Called with
+ * frame_lock held, so it never waits: if the writeback queue is full or
+ * there is no memory for the copy, the mappings are restored and false is
+ * returned so that the caller picks another victim. */
+/* frame_lock 을 잡은 채로 불리므로 기다리지 않습니다. writeback 큐가 가득 찼거나
+ * 사본을 둘 메모리가 없으면 매핑을 되돌리고 false 를 반환하며, 호출자는 다른 희생자를 고릅니다. */
 static bool file_backed_swap_out(struct page *page) {
     // victim의 페이지가 들어옴
-    struct file_page *file_page UNUSED = &page->file;
-    struct aux* aux = (struct aux *)page->uninit.aux; //file의 aux를 가져옴
-    if(pml4_is_dirty(thread_current()->pml4, page->va)) // 먼저 페이지가 dirty 인지 확인
+    struct file_page *file_page = &page->file;
+    struct frame *frame = page->frame;
+
+    // victim 은 다른 프로세스의 페이지이거나 fork 로 공유된 프레임일 수 있으므로 rmap 의 모든 매핑을 본다
+    vm_frame_unmap_all(frame);  // present bit을 0으로 만들어서 쓰는 도중의 수정을 막음 (dirty bit은 유지됨)
+    if(vm_frame_is_dirty(frame)) // 먼저 페이지가 dirty 인지 확인
     {   
-        // buffer(page->va)에 있는 데이터를 size만큼, file의 file_ofs부터 써줌
-        file_write_at(aux->file , page->va, aux->page_read_bytes ,aux->ofs);  // 변경 사항을 파일에 다시 기록
-        pml4_set_dirty(thread_current()->pml4, page->va, 0); // 변경 사항 다시 변경해줌
+        // 프레임의 사본을 writeback 스레드에 넘긴다. 프레임은 기록을 기다리지 않고 바로 재사용된다.
+        if (file_page->read_bytes > 0) {
+            struct wb_entry *entry = writeback_alloc(false);
+            if (entry == NULL) {
+                vm_frame_remap_all(frame);
+                wb_skip_cnt++;
+                return false;
+            }
+            writeback_queue(entry, page->area->file, frame_kva(frame), file_page->read_bytes, file_page->ofs);
+        }
+        vm_frame_set_dirty(frame, false); // 변경 사항 다시 변경해줌
 
     }
-    pml4_clear_page(thread_current()->pml4,page->va);  // present bit을 0으로 만들어서 디스크에 내려(swap out)있음
+    return true;
+}
+
+/* Queue the contents of the resident file-backed PAGE to be written back
+ * to its file. Used by msync(); the caller pins the frame and clears the
+ * dirty bits. May wait, so frame_lock must not be held. */
+/* 메모리에 있는 파일 페이지 PAGE 의 내용을 파일에 쓰도록 writeback 스레드에 넘깁니다.
+ * msync() 에서 쓰며, 프레임 고정과 dirty 비트 지우기는 호출자가 합니다.
+ * 기다릴 수 있으므로 frame_lock 을 잡지 않고 불러야 합니다. */
+void file_backed_writeback(struct page *page) {
+    struct file_page *file_page = &page->file;
 
+    ASSERT(page->frame != NULL);
+    writeback_page(page->area->file, frame_kva(page->frame), file_page->read_bytes, file_page->ofs);
 }
 
 /* Destory the file backed page. PAGE will be freed by the caller. */
 static void file_backed_destroy(struct page *page) {
-    struct file_page *file_page UNUSED = &page->file;
-    struct aux* aux = (struct aux *)page->uninit.aux; //file의 aux를 가져옴
-    if(pml4_is_dirty(thread_current()->pml4, page->va)) // 내용이 변경된 경우
+    struct file_page *file_page = &page->file;
+    struct thread *curr = thread_current();
+
+    if (page->frame == NULL) // 이미 쫓겨났거나 해제된 페이지는 파일에 반영되어 있음
+        return;
+
+    if(pml4_is_dirty(curr->pml4, page->va)) // 내용이 변경된 경우
     {   
-        // buffer(page->va)에 있는 데이터를 size만큼, file의 file_ofs부터 써줌
-        file_write_at(aux->file , page->va, aux->page_read_bytes ,aux->ofs);  // 변경 사항을 파일에 다시 기록
-        pml4_set_dirty(thread_current()->pml4, page->va, 0); // 변경 사항 다시 변경해줌
+        // munmap 이나 종료하는 스레드가 기록을 기다리지 않도록 writeback 스레드에 넘긴다
+        writeback_page(page->area->file, frame_kva(page->frame), file_page->read_bytes, file_page->ofs);
+        pml4_set_dirty(curr->pml4, page->va, 0); // 변경 사항 다시 변경해줌
 
     }
-    pml4_clear_page(thread_current()->pml4,page->va);  // present bit을 0으로 만들어서 디스크에 내려(swap out)있음
-
+    pml4_clear_page(curr->pml4,page->va);  // present bit을 0으로 만들어서 디스크에 내려(swap out)있음
+    vm_free_frame(page);
 }
 
 /* Do the mmap */
+/* 파일의 OFFSET 부터 LENGTH 바이트를 ADDR 에 매핑하는 영역 하나를 만듭니다.
+ * 페이지는 처음 접근할 때 만들어지므로 매핑 크기와 상관없이 일정한 시간이 걸립니다. */
 void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset) {
-		// 파일의 오프셋바이트 부터 length 바이트까지 가상주소공간에 데이터를 올리기 위해 load
-        int cnt;
-       
-        /* 사용자가 읽고싶은 영역의 길이 : length */
-		size_t read_bytes = length > file_length(file) ? file_length(file) : length;
-		size_t zero_bytes = PGSIZE - (read_bytes % PGSIZE);
-        struct file *re_file = file_reopen(file); // 독립적인 파일을 갖기 위함
-
-        // 연속된 페이지의 시작 주소 리턴
-        void *start_addr = addr;
-
-        if (read_bytes % PGSIZE == 0)
-        {
-            cnt = read_bytes / PGSIZE;
-        } else
-        {
-            cnt = read_bytes / PGSIZE + 1;
-        }
-        
+    struct supplemental_page_table *spt = &thread_current()->spt;
+    struct file *re_file = file_reopen(file); // 독립적인 파일을 갖기 위함
+    if (re_file == NULL)
+        return NULL;
 
-		while (read_bytes > 0 || zero_bytes > 0) {
-        size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-        size_t page_zero_bytes = PGSIZE - page_read_bytes;
+    /* 파일 끝을 넘는 부분은 0 으로 채워진다 */
+    off_t file_len = file_length(re_file);
+    size_t read_bytes = offset < file_len ? (size_t)(file_len - offset) : 0;
+    if (read_bytes > length)
+        read_bytes = length;
 
-        // aux를 설정 후 lazy_load_segment에 정보를 제공
-        struct aux *aux = (struct aux *)malloc(sizeof(struct aux));
-        aux->file = re_file;
-        aux->ofs = offset;
-        aux->page_read_bytes = page_read_bytes;
-        aux->writable = writable;
-        aux->page_zero_bytes = page_zero_bytes;
+    if (vm_area_create(spt, addr, length, VM_FILE, writable, re_file, offset, read_bytes) == NULL) {
+        file_close(re_file);
+        return NULL;
+    }
+    return addr;
+}
 
-        if (!vm_alloc_page_with_initializer(VM_FILE, addr, writable, lazy_load_segment, aux))
-            return false;
-        
-        struct page *page = spt_find_page(&thread_current()->spt, addr);
-        page->page_cnt = cnt;
-        cnt--;
+/* Resize the mapping of OLD_SIZE bytes at ADDR to NEW_SIZE bytes. The
+ * mapping grows in place when the pages after it are free; otherwise, if
+ * MAY_MOVE, it is moved to a free range together with its page table
+ * entries, without copying or re-reading any page. Returns the new start
+ * of the mapping, or NULL on failure. */
+/* ADDR 의 OLD_SIZE 바이트 매핑을 NEW_SIZE 바이트로 바꿉니다. 뒤쪽이 비어 있으면
+ * 그 자리에서 늘리고, 아니면 MAY_MOVE 일 때 빈 범위로 PTE 째 옮깁니다.
+ * 어느 경우에도 페이지를 복사하거나 파일에서 다시 읽지 않습니다.
+ * 매핑의 새 시작 주소를 반환하고, 실패하면 NULL 을 반환합니다. */
+void *do_mremap(void *addr, size_t old_size, size_t new_size, bool may_move) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+    struct vm_area *area = spt_find_area(spt, addr);
 
-        read_bytes -= page_read_bytes;
-        zero_bytes -= page_zero_bytes;
-        addr += PGSIZE;
-        offset += page_read_bytes;
+    if (area == NULL || area->start != addr || VM_TYPE(area->type) != VM_FILE
+        || (size_t) (area->end - area->start) != (size_t) pg_round_up(old_size) || new_size == 0)
+        return NULL;
+    // pg_round_up() 이 넘치지 않도록 사용자 주소 공간보다 큰 크기는 미리 거른다
+    if (new_size > KERN_BASE)
+        return NULL;
+
+    if (!vm_area_resize(spt, area, new_size)) {
+        void *start;
+        if (!may_move || (start = spt_find_free_range(spt, area->end, (size_t) pg_round_up(new_size))) == NULL)
+            return NULL;
+        // 먼저 같은 크기로 옮긴 뒤 새 자리에서 늘린다
+        if (!vm_area_move(spt, area, start) || !vm_area_resize(spt, area, new_size))
+            return NULL;
     }
-    return start_addr;
+
+    // 늘어난 부분도 do_mmap() 과 같이 파일 끝까지는 파일에서 읽고 나머지는 0 으로 채운다
+    off_t file_len = file_length(area->file);
+    size_t read_bytes = area->offset < file_len ? (size_t) (file_len - area->offset) : 0;
+    if (read_bytes > new_size)
+        read_bytes = new_size;
+    area->read_bytes = read_bytes;
+    return area->start;
 }
 
 /* Do the munmap */
+/* ADDR 에서 시작하는 mmap 영역을 통째로 해제합니다. 변경된 페이지는 파일에 기록됩니다. */
 void do_munmap(void *addr) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+    struct vm_area *area = spt_find_area(spt, addr);
 
-    struct page * page = spt_find_page(&thread_current()->spt, addr); // 1. 매핑 해제할 시작주소로 페이지를 가져옴
-    int page_cnt = page->page_cnt;
-    for (int i  = 0; i < page_cnt; i++)
-    {
-        if (page)
-            destroy(page);
-        addr += PGSIZE;
-        page = spt_find_page(&thread_current()->spt, addr);
-    }
-    
+    if (area == NULL || area->start != addr || VM_TYPE(area->type) != VM_FILE)
+        return;
+    // 페이지마다 invlpg 하지 않고 다 지운 뒤 한 번에 버린다
+    struct tlb_batch batch;
+    tlb_batch_begin(&batch, thread_current()->pml4);
+    vm_area_destroy(spt, area);
+    tlb_batch_end(&batch);
 }
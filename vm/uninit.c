@@ -10,6 +10,10 @@
 
 #include "vm/vm.h"
 #include "vm/uninit.h"
+#include <string.h>
+#include "threads/mmu.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 
 static bool uninit_initialize (struct page *page, void *kva);
 static void uninit_destroy (struct page *page);
@@ -52,6 +56,10 @@ uninit_initialize (struct page *page, void *kva) {
 	void *aux = uninit->aux;
 
 	/* TODO: You may need to fix this function. */
+	/* 초기화 함수가 없는 페이지 (스택) 는 0 으로 시작합니다. 쫓겨난 프레임에는
+	 * 다른 페이지의 내용이 남아 있고, zero 페이지에서 넘어온 페이지도 0 이어야 합니다. */
+	if (init == NULL)
+		memset (kva, 0, PGSIZE);
 	return uninit->page_initializer (page, uninit->type, kva) &&
 		(init ? init (page, aux) : true);
 }
@@ -70,6 +78,11 @@ uninit_destroy (struct page *page) {
 	/* TODO: Fill this function.
 	 * TODO: If you don't have anything to do, just return. */
 
+	/* 공유 zero 페이지에 매핑된 채로 남아 있으면 pml4_destroy() 가
+	 * zero 페이지를 해제하지 않도록 매핑을 지웁니다. */
+	if (vm_page_maps_zero (page))
+		pml4_clear_page (thread_current ()->pml4, page->va);
+
 	// struct aux *aux = page->uninit.aux;
 
 	// free(aux);
@@ -11,12 +11,122 @@
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "lib/kernel/list.h"
+#include "threads/synch.h"
+#include "userprog/process.h"
+#include "filesys/file.h"
+#include "devices/timer.h"
 /* 가상 메모리 서브시스템을 각 서브시스템의 초기화 코드를 호출함으로써 초기화합니다. */
 
-// 프레임 테이블 
-struct list frame_table;
+// 프레임 테이블: user pool 의 페이지 번호로 바로 찾는 프레임 서술자 배열.
+// 폴트 경로에서 서술자를 malloc 하지 않고, 시계 바늘은 배열을 순서대로 훑는다.
+struct frame *frame_table;
+uint8_t *frame_base;                   /* user pool 의 첫 페이지 = frame_table[0] */
+static size_t frame_cnt;               /* frame_table 의 크기 (user pool 의 페이지 수) */
+static size_t frame_used_cnt;          /* used 인 서술자 수 */
+static size_t frame_used_peak;         /* frame_used_cnt 의 최댓값 */
+// 프레임 테이블을 보호하는 락
+static struct lock frame_lock;
+// clock 알고리즘의 시계 바늘 (마지막으로 검사한 프레임의 인덱스)
+static size_t clock_hand;
+
+/* 페이지 교체 통계 */
+static long long evict_cnt;       /* 쫓아낸 프레임 수 */
+static long long clock_scan_cnt;  /* 희생자를 찾기 위해 검사한 프레임 수 */
+
+/* copy-on-write 통계 */
+static long long cow_share_cnt;   /* fork 시 복사하지 않고 공유한 페이지 수 */
+static long long cow_copy_cnt;    /* 쓰기 폴트에서 실제로 복사한 페이지 수 */
+static long long fork_cnt;        /* 주소 공간을 복사한 fork 수 */
+static long long fork_copy_cnt;   /* fork 에서 자식을 위해 새 프레임에 읽은 페이지 수 */
+
+/* spt_find_page 캐시 통계 */
+static long long spt_cache_hit_cnt;
+static long long spt_cache_miss_cnt;
+
+/* 페이지 아웃 데몬.
+ * 빈 user 프레임이 low watermark 아래로 떨어지면 깨어나서
+ * high watermark 에 닿을 때까지 프레임을 하나씩 쫓아냅니다. */
+size_t vm_pageout_low;                 /* 커널 명령줄 -wl, 0 이면 user pool 의 1/32 */
+size_t vm_pageout_high;                /* 커널 명령줄 -wh, 0 이면 low 의 2 배 */
+static struct semaphore pageout_sema;
+static bool pageout_pending;           /* 데몬이 이미 깨워졌으면 true */
+static long long pageout_wakeup_cnt;   /* 데몬이 깨어난 횟수 */
+static long long pageout_reclaim_cnt;  /* 데몬이 user pool 에 돌려준 프레임 수 */
+
+static void pageout_daemon(void *aux);
+
+/* 실행 파일의 읽기 전용 페이지를 담은 프레임을 (inode, 오프셋, 읽은 바이트 수) 로
+ * 찾는 테이블. 같은 프로그램을 실행하는 프로세스들은 코드 페이지를 한 프레임으로 공유합니다.
+ * frame_lock 으로 보호됩니다. */
+static struct hash text_frames;
+static long long text_share_cnt;       /* 다른 프로세스의 프레임을 그대로 매핑한 수 */
+
+static uint64_t text_hash(const struct hash_elem *e, void *aux);
+static bool text_less(const struct hash_elem *a, const struct hash_elem *b, void *aux);
+
+/* 공유 zero 페이지.
+ * 처음 읽기만 하는 anon 페이지는 프레임을 받지 않고 이 페이지에 읽기 전용으로 매핑되고,
+ * 처음 쓸 때 진짜 프레임을 받습니다 (copy-on-write). */
+static void *zero_kva;
+static long long zero_map_cnt;         /* zero 페이지에 매핑한 읽기 폴트 수 */
+static long long zero_copy_cnt;        /* zero 페이지에서 쓰기로 진짜 프레임을 받은 수 */
+
+/* fault-around: 파일에서 읽는 페이지에 읽기 폴트가 나면 같은 창 안의 이웃 페이지도
+ * 함께 올립니다. 창 크기는 커널 명령줄 -fa 로 바꿀 수 있고 1 이하이면 끕니다. */
+size_t vm_fault_around_pages = 4;
+static long long fault_around_cnt;     /* fault-around 로 미리 매핑한 페이지 수 */
+
+/* madvise 통계 */
+static long long willneed_cnt;         /* MADV_WILLNEED 로 미리 읽거나 올린 페이지 수 */
+static long long dontneed_cnt;         /* MADV_DONTNEED 로 버린 페이지 수 */
+static long long populate_cnt;         /* MAP_POPULATE 로 mmap 할 때 미리 올린 페이지 수 */
+static long long msync_cnt;            /* msync() 로 파일에 기록한 페이지 수 */
+
+static void vm_fault_around(struct supplemental_page_table *spt, struct page *page);
+
+/* KSM (kernel same-page merging).
+ * 백그라운드 스캐너가 프레임 테이블을 돌며 anon 프레임의 내용을 해시하고, 두 번 연속
+ * 해시가 같은 (자주 바뀌지 않는) 프레임을 KSM 테이블에서 같은 해시의 프레임과 비교합니다.
+ * 내용이 같으면 한쪽의 페이지들을 다른 프레임에 읽기 전용으로 옮기고 프레임 하나를 반납합니다.
+ * 합쳐진 프레임에 쓰면 fork 와 같은 copy-on-write 로 다시 나뉩니다.
+ * KSM 테이블과 스캐너의 위치는 frame_lock 으로 보호됩니다. */
+#define KSM_SLEEP_TICKS (TIMER_FREQ / 10) /* 스캐너가 깨어나는 간격 */
+size_t vm_ksm_pages = 64;              /* 커널 명령줄 -ksm, 한 번 깨어날 때 검사하는 프레임 수 */
+static struct hash ksm_frames;
+static size_t ksm_hand;                /* 스캐너가 마지막으로 검사한 프레임의 인덱스 */
+static long long ksm_scan_cnt;         /* 검사한 프레임 수 */
+static long long ksm_merge_cnt;        /* 다른 프레임으로 옮겨서 합친 페이지 수 */
+static long long ksm_unshare_cnt;      /* 합쳐진 프레임에 쓰기가 일어나 다시 복사한 수 */
+static long long ksm_sharing_cnt;      /* 지금 합쳐진 프레임을 함께 쓰고 있어서 절약된 프레임 수 */
+
+static void ksm_scanner(void *aux);
+static void ksm_forget(struct frame *frame);
+static uint64_t ksm_hash(const struct hash_elem *e, void *aux);
+static bool ksm_less(const struct hash_elem *a, const struct hash_elem *b, void *aux);
+
+/* 투명한 2 MB 페이지: 처음 내용이 0 인 anon 영역에서 정렬된 2 MB 블록에 처음 폴트가 나면
+ * 물리적으로 연속된 2 MB 를 받아 PDE 하나로 매핑합니다. 폴트 511 번과 페이지 테이블 한 장이
+ * 줄어듭니다. 4 KB 단위의 작업 (부분 munmap, 쫓아내기, fork 의 COW) 은 mmu.c 가 PDE 를
+ * 쪼개서 처리하며, 각 4 KB 페이지는 처음부터 자기 struct page 와 struct frame 을 갖습니다. */
+bool vm_thp;                           /* 커널 명령줄 -thp */
+static long long fault_cnt;            /* 처리한 페이지 폴트 수 */
+static long long thp_fault_cnt;        /* 2 MB 페이지로 채운 폴트 수 */
+static long long thp_fallback_cnt;     /* 정렬된 2 MB 를 구하지 못해 4 KB 로 처리한 폴트 수 */
+
+/* 프로세스별 RSS 상한: 상한에 닿은 프로세스는 빈 프레임이 있어도, 또 다른 프로세스의
+ * 페이지 대신 자기 페이지를 시계 알고리즘으로 골라 내보냅니다. 한 프로세스가 메모리를
+ * 마구 써도 다른 프로세스의 페이지가 밀려나지 않습니다. 상한은 fork 로 물려주고
+ * exec 후에도 유지됩니다. */
+#define RSS_LIMIT_MIN 16               /* 한 명령어가 건드리는 페이지를 모두 담을 수 있는 최소 상한 */
+size_t vm_rss_limit;                   /* 커널 명령줄 -rss */
+static long long rss_reclaim_cnt;      /* 상한 때문에 자기 페이지를 내보낸 수 */
+
+/* MADV_SEQUENTIAL 영역에서 fault-around 창을 몇 배로 늘릴지 */
+#define SEQUENTIAL_WINDOW_SCALE 4
 
 void vm_init(void) {
     vm_anon_init();
@@ -27,9 +137,69 @@ void vm_init(void) {
     register_inspect_intr();
     /* DO NOT MODIFY UPPER LINES. */
     /* TODO: Your code goes here. */
-    // 프레임 테이블 초기화 
-    list_init (&frame_table);
+    // 프레임 테이블 초기화: user pool 의 모든 페이지에 대한 서술자를 커널 풀에 한 번에 만든다
+    frame_base = palloc_user_pool(&frame_cnt);
+    frame_table = palloc_get_multiple(PAL_ASSERT | PAL_ZERO,
+                                      DIV_ROUND_UP(frame_cnt * sizeof *frame_table, PGSIZE));
+    for (size_t i = 0; i < frame_cnt; i++)
+        list_init(&frame_table[i].rmap);
+    lock_init (&frame_lock);
+    clock_hand = frame_cnt - 1;
+    hash_init(&text_frames, text_hash, text_less, NULL);
+    hash_init(&ksm_frames, ksm_hash, ksm_less, NULL);
+    ksm_hand = frame_cnt - 1;
+    // zero 페이지는 절대 쫓겨나지 않으므로 프레임 테이블에 넣지 않고 커널 풀에서 받는다
+    zero_kva = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+
+    // 아직 user 프레임을 쓰는 프로세스가 없으므로 지금 빈 프레임 수가 user pool 전체 크기다
+    size_t user_frames = palloc_user_free_cnt();
+    if (vm_pageout_low == 0)
+        vm_pageout_low = user_frames / 32 > 4 ? user_frames / 32 : 4;
+    if (vm_pageout_high <= vm_pageout_low)
+        vm_pageout_high = vm_pageout_low * 2;
+    if (vm_rss_limit != 0 && vm_rss_limit < RSS_LIMIT_MIN)
+        vm_rss_limit = RSS_LIMIT_MIN;
+    sema_init(&pageout_sema, 0);
+    pageout_pending = false;
+    if (thread_create("pageout", PRI_DEFAULT, pageout_daemon, NULL) == TID_ERROR)
+        PANIC("vm_init: cannot start pageout daemon");
+    if (vm_ksm_pages > 0 && thread_create("ksm", PRI_DEFAULT, ksm_scanner, NULL) == TID_ERROR)
+        PANIC("vm_init: cannot start KSM scanner");
+}
 
+/* Prints page replacement statistics. */
+/* 페이지 교체 통계를 출력합니다. */
+void vm_print_stats(void) {
+    printf("VM: frame table of %zu frames (%zu bytes each), %zu in use\n",
+           frame_cnt, sizeof *frame_table, frame_used_cnt);
+    printf("VM: %lld evictions, %lld frames scanned", evict_cnt, clock_scan_cnt);
+    if (evict_cnt > 0)
+        printf(" (%lld per eviction)", clock_scan_cnt / evict_cnt);
+    printf("\n");
+    printf("VM: %lld pages shared on fork, %lld copy-on-write copies\n",
+           cow_share_cnt, cow_copy_cnt);
+    printf("VM: %lld forks, %lld pages read into new frames on fork, peak %zu frames in use\n",
+           fork_cnt, fork_copy_cnt, frame_used_peak);
+    printf("VM: %lld page lookup cache hits, %lld misses\n",
+           spt_cache_hit_cnt, spt_cache_miss_cnt);
+    printf("VM: %lld reads mapped to the zero page, %lld copied on write\n",
+           zero_map_cnt, zero_copy_cnt);
+    printf("VM: %lld text pages shared between processes\n", text_share_cnt);
+    printf("VM: %lld pages mapped by fault-around (window %zu)\n",
+           fault_around_cnt, vm_fault_around_pages);
+    printf("VM: madvise prefetched %lld pages, dropped %lld pages\n",
+           willneed_cnt, dontneed_cnt);
+    printf("VM: %lld pages populated at mmap time\n", populate_cnt);
+    printf("VM: %lld pages written back by msync\n", msync_cnt);
+    printf("VM: KSM scanned %lld frames, merged %lld pages, %lld unshared on write, %lld frames saved now\n",
+           ksm_scan_cnt, ksm_merge_cnt, ksm_unshare_cnt, ksm_sharing_cnt);
+    printf("VM: %lld page faults, %lld filled whole 2 MB pages, %lld fell back to 4 KB\n",
+           fault_cnt, thp_fault_cnt, thp_fallback_cnt);
+    mmu_print_stats();
+    printf("VM: %lld frames reclaimed from processes at their RSS limit\n", rss_reclaim_cnt);
+    printf("VM: pageout daemon woke %lld times, reclaimed %lld frames (watermarks %zu/%zu)\n",
+           pageout_wakeup_cnt, pageout_reclaim_cnt, vm_pageout_low, vm_pageout_high);
+    anon_print_stats();
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -49,9 +219,21 @@ enum vm_type page_get_type(struct page *page) {
 }
 
 /* Helpers */
-static struct frame *vm_get_victim(void);
+#define EVICT_TRIES 8                  /* 기다려야 하는 희생자를 건너뛰며 고를 최대 횟수 */
+static struct frame *vm_get_victim(struct supplemental_page_table *owner);
 static bool vm_do_claim_page(struct page *page);
-static struct frame *vm_evict_frame(void);
+static bool vm_do_claim_page_frame(struct page *page, bool may_evict);
+static struct frame *vm_evict_frame(struct supplemental_page_table *owner);
+static struct frame *vm_evict_cluster(struct supplemental_page_table *owner);
+static struct frame *vm_get_frame_locked(bool may_evict);
+static struct frame *vm_get_frame_fast(void);
+static void pageout_kick_locked(void);
+static struct frame *frame_create(void *kva);
+static void vm_release_frame_locked(struct frame *frame);
+static void frame_map(struct frame *frame, struct page *page, uint64_t *pml4);
+static void frame_unmap(struct frame *frame, struct page *page);
+static void frame_detach_all(struct frame *frame);
+static void text_forget(struct frame *frame);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -94,51 +276,197 @@ err:
     return false;
 }
 
+/* VA 가 들어갈 조회 캐시 슬롯 */
+#define spt_cache_slot(spt, va) (&(spt)->cache[pg_no(va) % SPT_CACHE_SIZE])
+
 /* Find VA from spt and return page. On error, return NULL. */
 /* spt에서 VA를 찾아 페이지를 반환합니다. 오류가 발생하면 NULL을 반환합니다. */
 /* 목표 : va 를 가지고 page 찾기 
-    spt는 해시구조라 hasg_elem 을 가지고 page 찾아야함 */
+    spt는 해시구조라 hasg_elem 을 가지고 page 찾아야함 
+    페이지 폴트와 시스템 콜 주소 검사마다 불리므로 메모리를 할당하지 않고,
+    최근에 찾은 페이지를 먼저 캐시에서 확인한다. */
 struct page *spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
-    // struct page *page = NULL;
     /* TODO: Fill this function. */
-    
-    // dummy page 를 만들어서 hash_elem 을 추출한다.
-    struct page *page = (struct page *)malloc(sizeof(struct page));
+    void *upage = pg_round_down(va);
+    struct page **slot = spt_cache_slot(spt, upage);
+
+    if (*slot != NULL && (*slot)->va == upage) {
+        spt_cache_hit_cnt++;
+        return *slot;
+    }
+    spt_cache_miss_cnt++;
+
+    // 스택 위의 dummy page 로 hash_elem 을 만들어서 찾는다 (va 만 사용됨)
+    struct page key;
     struct hash_elem *e;
 
-    page->va = pg_round_down(va); 
-    e = hash_find(&spt->spt_hash, &page->spt_entry); // 찾고자하는 va에 해당하는 페이지의 hash_elem 추출
-    free(page); // dummy page - free 하기 
+    key.va = upage;
+    e = hash_find(&spt->spt_hash, &key.spt_entry); // 찾고자하는 va에 해당하는 페이지의 hash_elem 추출
 
     if (e != NULL)
     {
-        return hash_entry(e,struct page, spt_entry); // 실제 페이지 리턴
+        *slot = hash_entry(e,struct page, spt_entry); // 실제 페이지 리턴
+        return *slot;
     }
     return NULL;
 }
 
+/* Find the page for VA like spt_find_page(), creating it from the region
+ * that covers VA if it has not been touched yet. SPT must be the current
+ * thread's. */
+/* spt_find_page() 처럼 VA 의 페이지를 찾되, 아직 만들어지지 않았으면
+ * VA 를 포함하는 영역으로부터 uninit 페이지를 만듭니다.
+ * SPT 는 현재 스레드의 것이어야 합니다. */
+struct page *spt_lookup_page(struct supplemental_page_table *spt, void *va) {
+    struct page *page = spt_find_page(spt, va);
+    if (page != NULL)
+        return page;
+
+    struct vm_area *area = spt_find_area(spt, va);
+    if (area == NULL)
+        return NULL;
+
+    void *upage = pg_round_down(va);
+    if (!vm_alloc_page_with_initializer(area->type, upage, area->writable,
+                                        area->file != NULL ? lazy_load_segment : NULL, area))
+        return NULL;
+    page = spt_find_page(spt, upage);
+    page->area = area;
+    list_push_back(&area->pages, &page->area_elem);
+    return page;
+}
+
 /* Insert PAGE into spt with validation. */
 /* 유효성 검사와 함께 spt에 PAGE를 삽입합니다. */
 bool spt_insert_page(struct supplemental_page_table *spt UNUSED, struct page *page UNUSED) {
     // int succ = false;
     /* TODO: Fill this function. */
 
+    page->spt = spt;
     return page_insert(&spt->spt_hash, page);
 }
 
+/* Remove PAGE from spt and free it. */
+/* spt 에서 PAGE 를 빼고 해제합니다. */
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page) {
+    struct page **slot = spt_cache_slot(spt, page->va);
+
+    if (*slot == page)
+        *slot = NULL;
+    if (page->area != NULL)
+        list_remove(&page->area_elem);
+    hash_delete(&spt->spt_hash, &page->spt_entry);
     vm_dealloc_page(page);
-    return true;
+}
+
+/* *HAND 를 VM 이 쓰고 있는 다음 프레임으로 옮기고 그 프레임을 반환합니다.
+ * 배열 끝에 도달하면 처음으로 돌아가며, 쓰고 있는 프레임이 없으면 NULL 을 반환합니다. */
+static struct frame *frame_next_used(size_t *hand) {
+    for (size_t i = 0; i < frame_cnt; i++) {
+        *hand = *hand + 1 < frame_cnt ? *hand + 1 : 0;
+        if (frame_table[*hand].used)
+            return &frame_table[*hand];
+    }
+    return NULL;
+}
+
+/* 프레임을 매핑한 페이지 중 SPT 의 것이 있는지 */
+static bool frame_used_by(struct frame *frame, struct supplemental_page_table *spt) {
+    for (struct list_elem *e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e))
+        if (list_entry(e, struct page, rmap_elem)->spt == spt)
+            return true;
+    return false;
+}
+
+/* SPT 가 RSS 상한까지 더 올릴 수 있는 페이지 수 */
+static size_t spt_rss_room(struct supplemental_page_table *spt) {
+    if (spt->rss_limit == 0)
+        return SIZE_MAX;
+    return spt->rss < spt->rss_limit ? spt->rss_limit - spt->rss : 0;
 }
 
 /* Get the struct frame, that will be evicted. */
 /* 추방될 struct frame을 가져옵니다. */
-static struct frame *vm_get_victim(void) {
+/* enhanced second-chance (clock) 알고리즘
+ * 짝수 바퀴: (accessed, dirty) == (0, 0) 인 프레임을 비트를 건드리지 않고 찾는다.
+ * 홀수 바퀴: accessed == 0 인 프레임을 찾으면서 지나간 프레임의 accessed 비트를 지운다.
+ * 따라서 최대 네 바퀴 안에 고정(pinned)되지 않은 프레임을 반드시 찾는다.
+ * OWNER 가 NULL 이 아니면 OWNER 의 페이지가 매핑한 프레임만 고르고, 다른 프레임의 비트는
+ * 건드리지 않는다. frame_lock 을 잡은 상태에서 호출해야 한다. */
+static struct frame *vm_get_victim(struct supplemental_page_table *owner) {
     /* TODO: The policy for eviction is up to you. */
+    ASSERT(lock_held_by_current_thread(&frame_lock));
+
+    size_t used_cnt = frame_used_cnt;
+    for (int round = 0; round < 4; round++) {
+        for (size_t i = 0; i < used_cnt; i++) {
+            struct frame *frame = frame_next_used(&clock_hand);
+            clock_scan_cnt++;
+
+            if (frame->pinned || frame->ref_cnt == 0)
+                continue;
+            if (owner != NULL && !frame_used_by(frame, owner))
+                continue;
+
+            // 공유된 프레임은 매핑한 모든 주소 공간의 비트를 합쳐서 본다
+            bool accessed = vm_frame_is_accessed(frame);
+            struct page *page = frame_primary(frame);
+
+            // readahead 로 미리 읽은 페이지가 실제로 쓰였는지 기록
+            if (accessed && VM_TYPE(page->operations->type) == VM_ANON)
+                anon_readahead_settle(page, true);
+
+            if (round % 2 == 0) {
+                if (!accessed && !vm_frame_is_dirty(frame))
+                    return frame;
+            } else {
+                if (!accessed)
+                    return frame;
+                vm_frame_set_accessed(frame, false); // 두 번째 기회
+            }
+        }
+    }
+    return NULL;
+}
 
-    struct frame *victim = list_entry(list_pop_front(&frame_table), struct frame, frame_elem); // 추방될 프레임 요소 가져오기
-    
-    return victim;
+/* 희생자 VICTIM 과 함께 내보낼 페이지들을 CLUSTER 에 모으고 개수를 반환합니다.
+ * 같은 프로세스의 anon 페이지 중 최근에 접근되지 않은 것을 시계 바늘 앞쪽에서
+ * 찾아 가상 주소 순으로 정렬합니다. 이렇게 하면 주소 순으로 연속된 스왑 슬롯을 받습니다.
+ * VICTIM 이 공유되었거나 anon 페이지가 아니면 VICTIM 의 페이지 하나만 들어갑니다. */
+static size_t vm_gather_cluster(struct frame *victim, struct page *cluster[]) {
+    struct page *page = frame_primary(victim);
+    size_t cnt = 0;
+
+    cluster[cnt++] = page;
+    if (victim->ref_cnt != 1 || VM_TYPE(page->operations->type) != VM_ANON)
+        return cnt;
+
+    size_t idx = victim - frame_table;
+    size_t scan = frame_used_cnt;
+    if (scan > SWAP_CLUSTER_SIZE * 4)
+        scan = SWAP_CLUSTER_SIZE * 4;
+    for (size_t i = 1; i < scan && cnt < SWAP_CLUSTER_SIZE; i++) {
+        struct frame *frame = frame_next_used(&idx);
+        if (frame == victim)
+            break;
+        if (frame->pinned || frame->ref_cnt != 1)
+            continue;
+        struct page *other = frame_primary(frame);
+        if (other->pml4 != page->pml4 || VM_TYPE(other->operations->type) != VM_ANON
+            || pml4_is_accessed(other->pml4, other->va))
+            continue;
+        cluster[cnt++] = other;
+    }
+
+    // 가상 주소 순으로 삽입 정렬
+    for (size_t i = 1; i < cnt; i++) {
+        page = cluster[i];
+        size_t j = i;
+        for (; j > 0 && cluster[j - 1]->va > page->va; j--)
+            cluster[j] = cluster[j - 1];
+        cluster[j] = page;
+    }
+    return cnt;
 }
 
 /* Evict one page and return the corresponding frame.
@@ -146,11 +474,53 @@ static struct frame *vm_get_victim(void) {
 
 /* 한 페이지를 쫓아내고 해당하는 프레임을 반환합니다.
  * 오류가 발생하면 NULL을 반환합니다. */
-static struct frame *vm_evict_frame(void) {
-    struct frame *victim UNUSED = vm_get_victim();
-    /* TODO: swap out the victim and return the evicted frame. */
-    swap_out(victim->page); // 희생할 빅팀의 페이지 보내기
+static struct frame *vm_evict_frame(struct supplemental_page_table *owner) {
+    struct tlb_batch batch;
+
+    // 함께 내보내는 현재 프로세스의 페이지들은 TLB 항목을 끝에서 한 번에 버린다
+    tlb_batch_begin(&batch, thread_current()->pml4);
+    struct frame *frame = vm_evict_cluster(owner);
+    tlb_batch_end(&batch);
+    return frame;
+}
+
+/* OWNER 의 프레임 중에서 (NULL 이면 모든 프레임 중에서) 희생자를 골라 주변 페이지와
+ * 함께 내보내고 희생자의 프레임을 반환합니다. 희생자를 내보내려면 기다려야 하면
+ * (writeback 큐가 가득 참) 다음 희생자를 고르며, EVICT_TRIES 번 실패하면 NULL 을 반환합니다. */
+static struct frame *vm_evict_cluster(struct supplemental_page_table *owner) {
+    struct frame *victim UNUSED = NULL;
+    struct page *cluster[SWAP_CLUSTER_SIZE];
+    size_t cnt;
+
+    for (int try = 0; victim == NULL; try++) {
+        struct frame *frame = try < EVICT_TRIES ? vm_get_victim(owner) : NULL;
+        /* TODO: swap out the victim and return the evicted frame. */
+        if (frame == NULL)
+            return NULL;
+
+        struct page *page = frame_primary(frame);
+        cnt = vm_gather_cluster(frame, cluster);
+
+        // anon 희생자는 주변 페이지와 묶어서 한 번에 내보낸다. 연속된 슬롯이 없으면 희생자만 보낸다.
+        if (cnt > 1 && !anon_swap_out_cluster(cluster, cnt))
+            cnt = 1;
+        if (cnt > 1 || swap_out(page)) // 희생할 빅팀의 페이지 보내기
+            victim = frame;
+    }
+
+    // 함께 내보낸 페이지의 프레임은 바로 user pool 에 돌려준다
+    for (size_t i = 0; cnt > 1 && i < cnt; i++) {
+        struct frame *frame = cluster[i]->frame;
+        if (frame == victim)
+            continue;
+        frame_detach_all(frame);
+        vm_release_frame_locked(frame);
+        evict_cnt++;
+    }
 
+    // 프레임을 매핑하던 모든 페이지와의 연결을 끊는다
+    frame_detach_all(victim);
+    evict_cnt++;
     return victim; 
 }
 
@@ -164,31 +534,577 @@ static struct frame *vm_evict_frame(void) {
  * 이 함수는 항상 유효한 주소를 반환합니다. 즉, 사용자 풀 메모리가 가득 찬 경우,
  * 이 함수는 프레임을 쫓아내어 사용 가능한 메모리 공간을 확보합니다. */
 static struct frame *vm_get_frame(void) {
+    struct frame *frame = vm_get_frame_fast();
+    if (frame != NULL)
+        return frame;
+
+    lock_acquire(&frame_lock);
+    frame = vm_get_frame_locked(true);
+    lock_release(&frame_lock);
+    return frame;
+}
+
+/* Get a frame from the user pool without evicting anything, for
+ * speculative use such as swap readahead. Returns NULL if the pool is
+ * empty. The frame is pinned like the one from vm_get_frame(). */
+/* 다른 페이지를 쫓아내지 않고 user pool 에서만 프레임을 얻습니다 (스왑 readahead 용).
+ * 남은 메모리가 없으면 NULL 을 반환합니다. */
+struct frame *vm_get_free_frame(void) {
+    struct frame *frame = vm_get_frame_fast();
+    if (frame != NULL)
+        return frame;
+
+    lock_acquire(&frame_lock);
+    frame = vm_get_frame_locked(false);
+    lock_release(&frame_lock);
+    return frame;
+}
+
+/* 빈 프레임이 있으면 frame_lock 없이 user pool 에서 받고, 서술자를 등록할 때만 락을 잡습니다.
+ * 데몬이 쫓아내는 중이라도 그 한 번이 끝날 때까지만 기다리면 됩니다.
+ * RSS 상한에 닿았거나 빈 프레임이 없으면 NULL 을 반환하고, 호출자는 느린 경로로 갑니다. */
+static struct frame *vm_get_frame_fast(void) {
+    // 락 없이 읽지만, 자기 rss 를 늘리는 것은 자기 자신뿐이므로 실제보다 여유를 크게 보지 않는다
+    if (spt_rss_room(&thread_current()->spt) == 0)
+        return NULL;
+    void *kva = palloc_get_page(PAL_USER); // palloc 은 자기 락으로 보호된다
+    if (kva == NULL)
+        return NULL;
+
+    lock_acquire(&frame_lock);
+    struct frame *frame = frame_create(kva);
+    frame->pinned = true; // swap_in 이 끝날 때까지 쫓겨나지 않도록 고정
+    pageout_kick_locked();
+    lock_release(&frame_lock);
+    return frame;
+}
+
+/* frame_lock 을 잡은 상태에서, 빈 프레임이 low watermark 아래로 내려갔으면
+ * 폴트 경로 대신 데몬이 미리 쫓아내도록 깨웁니다. */
+static void pageout_kick_locked(void) {
+    ASSERT(lock_held_by_current_thread(&frame_lock));
+
+    if (!pageout_pending && palloc_user_free_cnt() < vm_pageout_low) {
+        pageout_pending = true;
+        sema_up(&pageout_sema);
+    }
+}
+
+/* frame_lock 을 이미 잡고 있는 상태에서 vm_get_frame() 과 같은 일을 합니다.
+ * MAY_EVICT 가 false 이면 빈 프레임이 없을 때 쫓아내지 않고 NULL 을 반환합니다. */
+static struct frame *vm_get_frame_locked(bool may_evict) {
     struct frame *frame = NULL;
     /* TODO: Fill this function. */
    
+    ASSERT(lock_held_by_current_thread(&frame_lock));
+
+    // RSS 상한에 닿은 프로세스는 빈 프레임이 있어도 자기 페이지를 내보내서 프레임을 얻는다
+    struct supplemental_page_table *spt = &thread_current()->spt;
+    if (spt_rss_room(spt) == 0) {
+        if (!may_evict)
+            return NULL;
+        frame = vm_evict_frame(spt);
+        if (frame != NULL) {
+            rss_reclaim_cnt++;
+            frame->pinned = true;
+            return frame;
+        }
+    }
+
     uint64_t *kva = palloc_get_page(PAL_USER); // palloc_get_page()를 통해 물리적 메모리를 할당하고, kva를 반환함 
 
+    pageout_kick_locked();
+    if (kva == NULL && !may_evict)
+        return NULL;
     if (kva == NULL) { 
-        frame =  vm_evict_frame(); // 쫓겨난 프레임 반환
-        // PANIC("panic!!!!!!");  // 페이지를 쫓아낸 프레임에 대한 패닉?
-        frame->page = NULL;
-        list_push_back(&frame_table, &frame->frame_elem);
-        return frame;
-    } 
-    frame = (struct frame *)malloc(sizeof(struct frame));
-
-    // 구조체 멤버 초기화
-    frame->kva = kva; 
-    frame->page = NULL;
-    
-    list_push_back(&frame_table, &frame->frame_elem); // 프레임 테이블에 넣기
+        frame =  vm_evict_frame(NULL); // 쫓겨난 프레임 반환 (프레임 테이블에 그대로 남아있음)
+        if (frame == NULL) {
+            // 쫓아낼 수 있는 프레임이 모두 writeback 큐를 기다리는 mmap 페이지였다. 폴트는
+            // 프레임 없이 진행할 수 없으므로 이때만 큐가 비기를 기다린 뒤 다시 고른다.
+            vm_writeback_wait(NULL);
+            frame = vm_evict_frame(NULL);
+        }
+        if (frame == NULL)
+            PANIC("vm_get_frame: out of frames");
+    } else
+        frame = frame_create(kva);
+    frame->pinned = true; // swap_in 이 끝날 때까지 쫓겨나지 않도록 고정
 
     ASSERT(frame != NULL);
-    ASSERT(frame->page == NULL);
+    ASSERT(frame->ref_cnt == 0 && list_empty(&frame->rmap));
     return frame;
 }
 
+/* frame_lock 을 잡은 상태에서 user pool 에서 막 받은 페이지 KVA 의 서술자를 초기화하고
+ * 쓰는 중으로 표시합니다. */
+static struct frame *frame_create(void *kva) {
+    struct frame *frame = vm_frame_of(kva);
+
+    ASSERT(!frame->used && list_empty(&frame->rmap));
+
+    // 구조체 멤버 초기화
+    frame->ref_cnt = 0;
+    frame->pinned = false;
+    frame->used = true;
+    frame->referenced = false;
+    frame->dirty = false;
+    frame->text_inode = NULL;
+    frame->ksm_sum = 0;
+    frame->ksm_listed = false;
+    frame->ksm_merged = false;
+    frame_used_cnt++;
+    if (frame_used_cnt > frame_used_peak)
+        frame_used_peak = frame_used_cnt;
+    return frame;
+}
+
+/* Returns the frame of the user pool page at KVA. */
+/* user pool 의 페이지 KVA 의 프레임 서술자를 반환합니다. */
+struct frame *vm_frame_of(const void *kva) {
+    size_t idx = pg_no(kva) - pg_no(frame_base);
+
+    ASSERT(pg_ofs(kva) == 0 && idx < frame_cnt);
+    return &frame_table[idx];
+}
+
+/* Drop PAGE's reference to its frame. The frame is returned to the user
+ * pool once no page shares it any more. */
+/* PAGE 가 가진 프레임의 참조를 놓습니다. 더 이상 공유하는 페이지가 없으면
+ * 프레임을 프레임 테이블에서 빼고 user pool 에 반납합니다. */
+void vm_free_frame(struct page *page) {
+    lock_acquire(&frame_lock);
+    struct frame *frame = page->frame;
+    if (frame != NULL) {
+        frame_unmap(frame, page);
+        if (frame->ref_cnt == 0) // 아직 다른 페이지가 공유 중이면 남겨 둔다
+            vm_release_frame_locked(frame);
+    }
+    lock_release(&frame_lock);
+}
+
+/* frame_lock 을 잡은 상태에서 PAGE 를 PML4 에 매핑된 FRAME 의 rmap 에 추가합니다. */
+static void frame_map(struct frame *frame, struct page *page, uint64_t *pml4) {
+    ASSERT(lock_held_by_current_thread(&frame_lock));
+    ASSERT(page->frame == NULL);
+
+    list_push_back(&frame->rmap, &page->rmap_elem);
+    frame->ref_cnt++;
+    page->frame = frame;
+    page->pml4 = pml4;
+    page->spt->rss++;
+    if (frame->ksm_merged && frame->ref_cnt > 1)
+        ksm_sharing_cnt++;
+}
+
+/* frame_lock 을 잡은 상태에서 PAGE 를 FRAME 의 rmap 에서 뺍니다. PTE 는 건드리지 않습니다. */
+static void frame_unmap(struct frame *frame, struct page *page) {
+    ASSERT(lock_held_by_current_thread(&frame_lock));
+    ASSERT(page->frame == frame);
+
+    list_remove(&page->rmap_elem);
+    frame->ref_cnt--;
+    page->frame = NULL;
+    page->spt->rss--;
+    if (frame->ksm_merged && frame->ref_cnt > 0)
+        ksm_sharing_cnt--;
+    // 떠난 매핑의 비트였을 수 있으므로 다음에는 남은 매핑을 다시 본다
+    frame->referenced = false;
+    frame->dirty = false;
+}
+
+/* frame_lock 을 잡은 상태에서 FRAME 과 그것을 매핑한 모든 페이지의 연결을 끊습니다. */
+static void frame_detach_all(struct frame *frame) {
+    while (!list_empty(&frame->rmap))
+        frame_unmap(frame, frame_primary(frame));
+    text_forget(frame); // 내용이 곧 바뀌므로 더 이상 공유할 수 없다
+    ksm_forget(frame);
+}
+
+/* frame_lock 을 잡은 상태에서 FRAME 을 text 프레임 테이블에서 뺍니다. */
+static void text_forget(struct frame *frame) {
+    ASSERT(lock_held_by_current_thread(&frame_lock));
+
+    if (frame->text_inode != NULL) {
+        hash_delete(&text_frames, &frame->text_elem);
+        frame->text_inode = NULL;
+    }
+}
+
+/* PAGE 가 파일에서 읽어 와야 하는 실행 파일의 읽기 전용 페이지이면 그 위치를 KEY 에 채우고
+ * true 를 반환합니다. 같은 위치의 페이지는 어느 프로세스에서나 내용이 같습니다. */
+static bool page_text_key(struct page *page, struct frame *key) {
+    struct vm_area *area = page->area;
+
+    if (area == NULL || area->file == NULL || area->writable || VM_TYPE(area->type) != VM_ANON)
+        return false;
+    // 처음 만들어진 페이지이거나, 쫓겨날 때 버려져서 파일에서 다시 읽어야 하는 페이지
+    if (page->operations->type != VM_UNINIT && !anon_backed_by_file(page))
+        return false;
+    key->text_inode = file_get_inode(area->file);
+    key->text_ofs = vm_area_page_offset(area, page->va);
+    key->text_read_bytes = vm_area_page_read_bytes(area, page->va);
+    return true;
+}
+
+/* 다른 프로세스가 이미 올려 둔 KEY 위치의 실행 파일 페이지가 있으면 그 프레임을 PAGE 에
+ * 읽기 전용으로 매핑하고 true 를 반환합니다. */
+static bool vm_share_text(struct page *page, struct frame *key) {
+    struct thread *curr = thread_current();
+
+    lock_acquire(&frame_lock);
+    struct hash_elem *e = hash_find(&text_frames, &key->text_elem);
+    struct frame *frame = e != NULL ? hash_entry(e, struct frame, text_elem) : NULL;
+    if (frame == NULL || !pml4_set_page(curr->pml4, page->va, frame_kva(frame), false)) {
+        lock_release(&frame_lock);
+        return false;
+    }
+    // 내용은 이미 프레임에 있으므로 파일에서 읽지 않고 페이지 타입만 초기화한다
+    if (page->operations->type == VM_UNINIT) {
+        struct uninit_page *uninit = &page->uninit;
+        uninit->page_initializer(page, uninit->type, frame_kva(frame));
+    }
+    frame_map(frame, page, curr->pml4);
+    text_share_cnt++;
+    lock_release(&frame_lock);
+    return true;
+}
+
+/* 방금 KEY 위치의 내용을 읽어 온 FRAME 을 다른 프로세스가 찾을 수 있게 등록합니다.
+ * 그 사이에 다른 프로세스가 같은 페이지를 등록했다면 FRAME 은 등록하지 않습니다. */
+static void text_register(struct frame *frame, const struct frame *key) {
+    lock_acquire(&frame_lock);
+    frame->text_inode = key->text_inode;
+    frame->text_ofs = key->text_ofs;
+    frame->text_read_bytes = key->text_read_bytes;
+    if (hash_insert(&text_frames, &frame->text_elem) != NULL)
+        frame->text_inode = NULL;
+    lock_release(&frame_lock);
+}
+
+static uint64_t text_hash(const struct hash_elem *e, void *aux UNUSED) {
+    const struct frame *frame = hash_entry(e, struct frame, text_elem);
+
+    return hash_bytes(&frame->text_inode, sizeof frame->text_inode)
+           ^ hash_int(frame->text_ofs) ^ hash_int(frame->text_read_bytes);
+}
+
+static bool text_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED) {
+    const struct frame *a = hash_entry(a_, struct frame, text_elem);
+    const struct frame *b = hash_entry(b_, struct frame, text_elem);
+
+    if (a->text_inode != b->text_inode)
+        return a->text_inode < b->text_inode;
+    if (a->text_ofs != b->text_ofs)
+        return a->text_ofs < b->text_ofs;
+    return a->text_read_bytes < b->text_read_bytes;
+}
+
+/* Record that PAGE maps FRAME in the address space PML4. The caller
+ * installs the PTE itself. */
+/* PAGE 가 PML4 주소 공간에서 FRAME 을 매핑한다고 rmap 에 기록합니다.
+ * PTE 는 호출자가 직접 설치합니다. */
+void vm_map_frame(struct frame *frame, struct page *page, uint64_t *pml4) {
+    lock_acquire(&frame_lock);
+    frame_map(frame, page, pml4);
+    lock_release(&frame_lock);
+}
+
+/* Mark FRAME not present in every address space that maps it. Accessed
+ * and dirty bits are preserved. */
+/* FRAME 을 매핑한 모든 주소 공간에서 PTE 를 not present 로 만듭니다.
+ * accessed, dirty 비트는 남습니다. */
+void vm_frame_unmap_all(struct frame *frame) {
+    struct list_elem *e;
+
+    for (e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, rmap_elem);
+        pml4_clear_page(page->pml4, page->va);
+    }
+}
+
+/* Map FRAME again in every address space that maps it, undoing
+ * vm_frame_unmap_all() when an eviction is abandoned. Shared frames stay
+ * read-only and the dirty bits are kept. */
+/* 쫓아내기를 그만둘 때 vm_frame_unmap_all() 을 되돌립니다. FRAME 을 매핑한 모든 주소 공간에
+ * 다시 매핑하며, 공유된 프레임은 읽기 전용으로 두고 dirty 비트는 그대로 남깁니다. */
+void vm_frame_remap_all(struct frame *frame) {
+    bool dirty = vm_frame_is_dirty(frame);
+    struct list_elem *e;
+
+    for (e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, rmap_elem);
+        pml4_set_page(page->pml4, page->va, frame_kva(frame), page->writable && frame->ref_cnt == 1);
+    }
+    vm_frame_set_dirty(frame, dirty); // 새로 만든 PTE 에는 dirty 비트가 없다
+}
+
+/* Returns true if any mapping of FRAME was accessed. */
+/* FRAME 을 매핑한 주소 공간 중 하나라도 접근했으면 true 를 반환합니다. */
+bool vm_frame_is_accessed(struct frame *frame) {
+    struct list_elem *e;
+
+    if (frame->referenced)
+        return true;
+    for (e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, rmap_elem);
+        if (pml4_is_accessed(page->pml4, page->va))
+            return frame->referenced = true;
+    }
+    return false;
+}
+
+/* Returns true if any mapping of FRAME was written. */
+/* FRAME 을 매핑한 주소 공간 중 하나라도 썼으면 true 를 반환합니다. */
+bool vm_frame_is_dirty(struct frame *frame) {
+    struct list_elem *e;
+
+    if (frame->dirty)
+        return true;
+    for (e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, rmap_elem);
+        if (pml4_is_dirty(page->pml4, page->va))
+            return frame->dirty = true;
+    }
+    return false;
+}
+
+/* Set the accessed bit of every mapping of FRAME to ACCESSED. */
+/* FRAME 을 매핑한 모든 PTE 의 accessed 비트를 ACCESSED 로 설정합니다. */
+void vm_frame_set_accessed(struct frame *frame, bool accessed) {
+    struct list_elem *e;
+
+    frame->referenced = accessed;
+    for (e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, rmap_elem);
+        pml4_set_accessed(page->pml4, page->va, accessed);
+    }
+}
+
+/* Set the dirty bit of every mapping of FRAME to DIRTY. */
+/* FRAME 을 매핑한 모든 PTE 의 dirty 비트를 DIRTY 로 설정합니다. */
+void vm_frame_set_dirty(struct frame *frame, bool dirty) {
+    struct list_elem *e;
+
+    frame->dirty = dirty;
+    for (e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, rmap_elem);
+        pml4_set_dirty(page->pml4, page->va, dirty);
+    }
+}
+
+/* frame_lock 을 잡은 상태에서 FRAME 을 프레임 테이블에서 빼고 user pool 에 반납합니다. */
+static void vm_release_frame_locked(struct frame *frame) {
+    ASSERT(lock_held_by_current_thread(&frame_lock));
+
+    text_forget(frame);
+    ksm_forget(frame);
+    ASSERT(frame->used && list_empty(&frame->rmap));
+    // 서술자는 배열에 그대로 남으므로 시계 바늘을 고칠 필요가 없다
+    frame->used = false;
+    frame_used_cnt--;
+    palloc_free_page(frame_kva(frame));
+}
+
+/* Background page-out daemon. Sleeps until the number of free user frames
+ * drops below vm_pageout_low, then evicts frames one at a time and returns
+ * them to the user pool until vm_pageout_high frames are free, so that
+ * faulting threads rarely evict on their own. frame_lock is dropped after
+ * every eviction, so a fault waits for at most one write. */
+/* 백그라운드 페이지 아웃 데몬. 빈 user 프레임이 vm_pageout_low 아래로 떨어질 때까지
+ * 잠들어 있다가, vm_pageout_high 개가 빌 때까지 하나씩 쫓아내서 user pool 에 돌려줍니다.
+ * 폴트를 처리하는 스레드가 직접 쫓아낼 일이 줄어듭니다. 쫓아낼 때마다 frame_lock 을
+ * 놓으므로 폴트는 많아야 쓰기 한 번만 기다립니다. */
+static void pageout_daemon(void *aux UNUSED) {
+    for (;;) {
+        sema_down(&pageout_sema);
+        pageout_wakeup_cnt++;
+
+        while (palloc_user_free_cnt() < vm_pageout_high) {
+            lock_acquire(&frame_lock);
+            struct frame *frame = vm_evict_frame(NULL);
+            if (frame != NULL) {
+                vm_release_frame_locked(frame);
+                pageout_reclaim_cnt++;
+            }
+            lock_release(&frame_lock);
+            if (frame == NULL) // 모두 고정되어 있거나 스왑이 가득 찼다
+                break;
+        }
+
+        lock_acquire(&frame_lock);
+        pageout_pending = false;
+        lock_release(&frame_lock);
+    }
+}
+
+/* frame_lock 을 잡은 상태에서 FRAME 을 KSM 테이블에서 뺍니다.
+ * 합쳐진 프레임이었다면 그 표시도 지웁니다. */
+static void ksm_forget(struct frame *frame) {
+    ASSERT(lock_held_by_current_thread(&frame_lock));
+
+    if (frame->ksm_listed) {
+        hash_delete(&ksm_frames, &frame->ksm_elem);
+        frame->ksm_listed = false;
+    }
+    if (frame->ksm_merged) {
+        if (frame->ref_cnt > 1)
+            ksm_sharing_cnt -= frame->ref_cnt - 1;
+        frame->ksm_merged = false;
+    }
+}
+
+/* FRAME 을 다른 프레임과 합칠 수 있는지: 고정되지 않았고, 실행 파일 공유 프레임이 아니며,
+ * 매핑한 모든 페이지가 anon 페이지이고 지금 이 프레임에 present 로 매핑되어 있어야 한다.
+ * 해제 중인 페이지는 PTE 가 이미 지워져 있으므로 여기서 걸러진다. */
+static bool ksm_can_merge(struct frame *frame) {
+    if (frame->pinned || frame->ref_cnt == 0 || frame->text_inode != NULL)
+        return false;
+    for (struct list_elem *e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, rmap_elem);
+        if (page->operations->type != VM_ANON || pml4_get_page(page->pml4, page->va) != frame_kva(frame))
+            return false;
+        // 합치려면 PTE 를 바꿔야 하므로 2 MB 페이지가 쪼개진다. 그럴 가치가 없다
+        if (pml4_is_huge(page->pml4, page->va))
+            return false;
+    }
+    return true;
+}
+
+/* FRAME 을 매핑한 모든 PTE 의 쓰기 권한을 WRITABLE 로 바꿉니다. 권한을 돌려줄 때는
+ * 혼자 쓰는 프레임의 쓰기 가능한 페이지만 돌려준다 (공유 프레임은 원래 읽기 전용). */
+static void ksm_set_writable(struct frame *frame, bool writable) {
+    for (struct list_elem *e = list_begin(&frame->rmap); e != list_end(&frame->rmap); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, rmap_elem);
+        if (!writable || (frame->ref_cnt == 1 && page->writable))
+            pml4_set_writable(page->pml4, page->va, writable);
+    }
+}
+
+/* frame_lock 을 잡은 상태에서 FRAME 의 내용이 STABLE 과 같으면 FRAME 의 페이지들을 STABLE 로
+ * 읽기 전용으로 옮기고 FRAME 을 반납합니다. */
+static void ksm_merge(struct frame *frame, struct frame *stable) {
+    // 비교하는 동안 내용이 바뀌지 않도록 먼저 쓰기를 막는다. 그 뒤의 쓰기는 폴트를 내고
+    // frame_lock 에서 기다린다.
+    ksm_set_writable(frame, false);
+    ksm_set_writable(stable, false);
+    if (memcmp(frame_kva(frame), frame_kva(stable), PGSIZE) != 0) {
+        ksm_set_writable(frame, true);
+        ksm_set_writable(stable, true);
+        return;
+    }
+
+    if (!stable->ksm_merged) {
+        stable->ksm_merged = true;
+        ksm_sharing_cnt += stable->ref_cnt - 1;
+    }
+    while (!list_empty(&frame->rmap)) {
+        struct page *page = frame_primary(frame);
+        // 쫓아낼 때 내용을 버려도 되는지 판단하므로 dirty 와 accessed 비트를 옮겨 준다
+        bool dirty = pml4_is_dirty(page->pml4, page->va);
+        bool accessed = pml4_is_accessed(page->pml4, page->va);
+
+        frame_unmap(frame, page);
+        frame_map(stable, page, page->pml4);
+        pml4_clear_page(page->pml4, page->va);
+        pml4_set_page(page->pml4, page->va, frame_kva(stable), false);
+        pml4_set_dirty(page->pml4, page->va, dirty);
+        pml4_set_accessed(page->pml4, page->va, accessed);
+        ksm_merge_cnt++;
+    }
+    vm_release_frame_locked(frame);
+}
+
+/* frame_lock 을 잡은 상태에서 FRAME 하나를 검사합니다. */
+static void ksm_scan_frame(struct frame *frame) {
+    ksm_scan_cnt++;
+    if (!ksm_can_merge(frame))
+        return;
+
+    uint64_t sum = hash_bytes(frame_kva(frame), PGSIZE);
+    if (sum != frame->ksm_sum) {
+        // 지난번 검사 이후 내용이 바뀐 프레임은 곧 또 바뀔 수 있으므로 아직 합치지 않는다
+        ksm_forget(frame);
+        frame->ksm_sum = sum;
+        return;
+    }
+    if (frame->ksm_listed)
+        return;
+
+    struct hash_elem *e = hash_insert(&ksm_frames, &frame->ksm_elem);
+    if (e == NULL) {
+        frame->ksm_listed = true;
+        return;
+    }
+    struct frame *stable = hash_entry(e, struct frame, ksm_elem);
+    if (ksm_can_merge(stable))
+        ksm_merge(frame, stable);
+}
+
+/* Background same-page merging scanner. Every KSM_SLEEP_TICKS it checks
+ * the next vm_ksm_pages frames of the frame table and merges anonymous
+ * frames whose contents are identical into one read-only frame. */
+/* KSM 스캐너. KSM_SLEEP_TICKS 마다 프레임 테이블의 다음 vm_ksm_pages 개 프레임을 검사해서
+ * 내용이 같은 anon 프레임들을 읽기 전용 프레임 하나로 합칩니다. */
+static void ksm_scanner(void *aux UNUSED) {
+    for (;;) {
+        timer_sleep(KSM_SLEEP_TICKS);
+        for (size_t i = 0; i < vm_ksm_pages; i++) {
+            // 프레임마다 락을 놓아 폴트를 처리하는 스레드가 오래 기다리지 않게 한다
+            lock_acquire(&frame_lock);
+            struct frame *frame = frame_next_used(&ksm_hand);
+            if (frame == NULL) {
+                lock_release(&frame_lock);
+                break;
+            }
+            ksm_scan_frame(frame);
+            lock_release(&frame_lock);
+            // 같은 우선순위의 대기자는 락을 놓아도 바로 돌지 못하므로 양보해서 다시 잡기 전에 먼저 돌게 한다
+            thread_yield();
+        }
+    }
+}
+
+static uint64_t ksm_hash(const struct hash_elem *e, void *aux UNUSED) {
+    const struct frame *frame = hash_entry(e, struct frame, ksm_elem);
+
+    return hash_bytes(&frame->ksm_sum, sizeof frame->ksm_sum);
+}
+
+static bool ksm_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED) {
+    return hash_entry(a_, struct frame, ksm_elem)->ksm_sum < hash_entry(b_, struct frame, ksm_elem)->ksm_sum;
+}
+
+/* Share SRC's frame with DST read-only in the current thread's address
+ * space, write-protecting it in PARENT as well. Returns false if SRC is
+ * not resident. */
+/* fork 시 부모 페이지 SRC 의 프레임을 자식 페이지 DST 와 읽기 전용으로 공유합니다.
+ * 두 페이지 모두 rmap 에 들어가므로 공유 중인 프레임도 교체될 수 있습니다.
+ * SRC 가 메모리에 없으면 false 를 반환합니다. */
+static bool vm_share_frame(struct thread *parent, struct page *dst, struct page *src) {
+    struct thread *curr = thread_current();
+    bool shared = false;
+
+    lock_acquire(&frame_lock);
+    struct frame *frame = src->frame;
+    if (frame != NULL && pml4_set_page(curr->pml4, dst->va, frame_kva(frame), false)) {
+        // 부모가 이미 쓴 페이지이면 자식의 PTE 에도 dirty 를 남긴다. 부모의 dirty PTE 는
+        // COW 복사나 종료로 먼저 사라질 수 있으므로, anon 페이지는 실행 파일과 달라졌다는
+        // 사실을 양쪽 페이지에 기억해 둔다. 그러지 않으면 쫓겨날 때 실행 파일과 같다고 보고 버려진다.
+        if (pml4_is_dirty(parent->pml4, src->va)) {
+            pml4_set_dirty(curr->pml4, dst->va, true);
+            if (src->operations->type == VM_ANON)
+                src->anon.dirtied = dst->anon.dirtied = true;
+        }
+        pml4_set_writable(parent->pml4, src->va, false);
+        dst->frame = NULL;
+        frame_map(frame, dst, curr->pml4);
+        cow_share_cnt++;
+        shared = true;
+    }
+    lock_release(&frame_lock);
+    return shared;
+}
+
 /* Growing the stack. */
 static void vm_stack_growth(void *addr UNUSED) {
     // anon 페이지를 할당해서 스택 크기 증가
@@ -197,7 +1113,272 @@ static void vm_stack_growth(void *addr UNUSED) {
 }
 
 /* Handle the fault on write_protected page */
+/* 쓰기 보호된 페이지에 대한 폴트를 처리합니다 (copy-on-write).
+ * 다른 페이지와 공유 중인 프레임이면 새 프레임에 복사해서 옮겨가고,
+ * 혼자 남은 프레임이면 쓰기 권한만 다시 줍니다. */
 static bool vm_handle_wp(struct page *page UNUSED) {
+    struct thread *curr = thread_current();
+
+    // zero 페이지를 보고 있던 페이지에 처음 쓰는 경우: 이제야 진짜 프레임을 받는다
+    if (vm_page_maps_zero(page)) {
+        pml4_clear_page(curr->pml4, page->va);
+        zero_copy_cnt++;
+        return vm_do_claim_page(page);
+    }
+
+    lock_acquire(&frame_lock);
+    struct frame *old = page->frame;
+    if (old == NULL) { // 그 사이에 쫓겨났다면 not present 폴트로 다시 들어옴
+        lock_release(&frame_lock);
+        return true;
+    }
+    // 이제 쓰이므로 실행 파일과 달라진다. 공유 프레임에 남은 다른 페이지의 PTE 만으로는
+    // 알 수 없으므로 페이지에 기억해 둔다.
+    if (page->operations->type == VM_ANON)
+        page->anon.dirtied = true;
+
+    if (old->ref_cnt > 1) {
+        // 새 프레임을 받는 동안 공유 중인 프레임이 쫓겨나지 않도록 고정
+        old->pinned = true;
+        struct frame *frame = vm_get_frame_locked(true);
+        old->pinned = false;
+        memcpy(frame_kva(frame), frame_kva(old), PGSIZE);
+
+        frame_unmap(old, page);
+        frame_map(frame, page, curr->pml4);
+        pml4_clear_page(curr->pml4, page->va);
+        pml4_set_page(curr->pml4, page->va, frame_kva(frame), true);
+        frame->pinned = false;
+        cow_copy_cnt++;
+        if (old->ksm_merged)
+            ksm_unshare_cnt++;
+    } else {
+        // 마지막 남은 페이지: 쓰기 권한만 돌려준다
+        pml4_set_writable(curr->pml4, page->va, true);
+    }
+    lock_release(&frame_lock);
+    return true;
+}
+
+/* 아직 초기화되지 않은 anon 페이지 중 처음 내용이 모두 0 인 것인지 확인합니다.
+ * 스택처럼 초기화 함수가 없거나, 영역 안에서 파일로부터 읽을 바이트가 없는 페이지입니다. */
+static bool page_is_zero_fill(struct page *page) {
+    if (page->operations->type != VM_UNINIT || VM_TYPE(page->uninit.type) != VM_ANON)
+        return false;
+    if (page->uninit.init == NULL)
+        return true;
+    return page->area != NULL && vm_area_page_read_bytes(page->area, page->va) == 0;
+}
+
+/* ADDR 을 포함하는 정렬된 2 MB 블록을 2 MB 페이지로 채울 수 있는지: 블록 전체가 처음
+ * 내용이 0 인 하나의 anon 영역 안에 있고, 그 안의 페이지가 아직 하나도 만들어지지 않았어야
+ * 한다. 한 번이라도 만들어진 페이지가 있으면 그 내용이나 스왑 위치를 버릴 수 없다. */
+static bool vm_huge_eligible(struct supplemental_page_table *spt, struct vm_area *area, void *start) {
+    if (area == NULL || VM_TYPE(area->type) != VM_ANON || !area->writable)
+        return false;
+    if (start < area->start || start + HPGSIZE > area->end)
+        return false;
+    if (area->file != NULL && area->read_bytes > (size_t) (start - area->start))
+        return false;
+    for (void *va = start; va < start + HPGSIZE; va += PGSIZE)
+        if (spt_find_page(spt, va) != NULL)
+            return false;
+    return true;
+}
+
+/* ADDR 을 포함하는 2 MB 블록 전체를 물리적으로 연속된 2 MB 프레임으로 채우고 PDE 하나로
+ * 매핑합니다. 블록의 512 페이지는 모두 anon 페이지로 초기화되어 각자 프레임을 갖습니다.
+ * 블록이 조건에 맞지 않거나 정렬된 빈 메모리가 없으면 false 를 반환하고, 호출자는 평소처럼
+ * 4 KB 페이지 하나를 올립니다. 2 MB 를 얻기 위해 다른 페이지를 쫓아내지는 않습니다. */
+static bool vm_try_huge_fault(struct supplemental_page_table *spt, void *addr) {
+    struct thread *curr = thread_current();
+    struct vm_area *area = spt_find_area(spt, addr);
+    void *start = (void *) ((uint64_t) addr & ~(HPGSIZE - 1));
+    size_t cnt = HPGSIZE / PGSIZE;
+
+    if (!vm_huge_eligible(spt, area, start))
+        return false;
+    // 데몬이 지키려는 여유 프레임까지 써 가며 2 MB 를 만들지는 않는다
+    if (palloc_user_free_cnt() < cnt + vm_pageout_high || spt_rss_room(spt) < cnt) {
+        thp_fallback_cnt++;
+        return false;
+    }
+    uint8_t *run = palloc_get_aligned(PAL_USER | PAL_ZERO, cnt, cnt);
+    if (run == NULL) {
+        thp_fallback_cnt++;
+        return false;
+    }
+    // 매핑하기 전에 struct page 를 모두 만들어 둔다. 실패해도 남은 uninit 페이지는 정상 상태다
+    for (void *va = start; va < start + HPGSIZE; va += PGSIZE)
+        if (spt_lookup_page(spt, va) == NULL) {
+            palloc_free_multiple(run, cnt);
+            return false;
+        }
+
+    lock_acquire(&frame_lock);
+    if (!pml4_set_huge_page(curr->pml4, start, run, area->writable)) {
+        lock_release(&frame_lock);
+        palloc_free_multiple(run, cnt);
+        return false;
+    }
+    for (size_t i = 0; i < cnt; i++) {
+        struct page *page = spt_find_page(spt, start + i * PGSIZE);
+        struct uninit_page *uninit = &page->uninit;
+        // 내용은 이미 0 이므로 lazy_load 없이 페이지 타입만 초기화한다
+        uninit->page_initializer(page, uninit->type, run + i * PGSIZE);
+        frame_map(frame_create(run + i * PGSIZE), page, curr->pml4);
+    }
+    thp_fault_cnt++;
+    lock_release(&frame_lock);
+    return true;
+}
+
+/* PAGE 를 현재 주소 공간에서 공유 zero 페이지에 읽기 전용으로 매핑합니다. */
+static bool vm_map_zero_page(struct page *page) {
+    if (!pml4_set_page(thread_current()->pml4, page->va, zero_kva, false))
+        return false;
+    zero_map_cnt++;
+    return true;
+}
+
+/* Returns true if PAGE is currently mapped to the shared zero page in the
+ * current address space. */
+/* PAGE 가 현재 주소 공간에서 공유 zero 페이지에 매핑되어 있으면 true 를 반환합니다. */
+bool vm_page_maps_zero(struct page *page) {
+    return page->frame == NULL && zero_kva != NULL
+           && pml4_get_page(thread_current()->pml4, page->va) == zero_kva;
+}
+
+/* MADV_SEQUENTIAL 영역에서 폴트 난 곳보다 WINDOW 페이지 이상 뒤에 있는 WINDOW 개의
+ * 페이지의 accessed 비트를 지웁니다. 다시 읽히지 않을 페이지들이므로 시계 알고리즘이
+ * 다른 페이지보다 먼저 희생자로 고르게 됩니다. */
+static void vm_deactivate_behind(struct supplemental_page_table *spt, struct vm_area *area,
+                                 void *va, size_t window) {
+    lock_acquire(&frame_lock);
+    for (size_t i = window + 1; i <= 2 * window; i++) {
+        if ((size_t) (va - area->start) < i * PGSIZE)
+            break;
+        struct page *page = spt_find_page(spt, va - i * PGSIZE);
+        if (page != NULL && page->frame != NULL && !page->frame->pinned)
+            vm_frame_set_accessed(page->frame, false);
+    }
+    lock_release(&frame_lock);
+}
+
+/* MADV_SEQUENTIAL 영역에서 앞쪽으로 미리 읽고 뒤쪽으로 쫓겨나게 할 창의 크기 (페이지 수) */
+static size_t sequential_window(void) {
+    return (vm_fault_around_pages > 1 ? vm_fault_around_pages : 1) * SEQUENTIAL_WINDOW_SCALE;
+}
+
+/* PAGE 에서 폴트가 났을 때 PAGE 가 MADV_SEQUENTIAL 영역에 있으면 한참 지나간 페이지들이
+ * 먼저 쫓겨나게 합니다. 파일 영역뿐 아니라 anon 영역에도 적용됩니다. */
+static void vm_sequential_fault(struct supplemental_page_table *spt, struct page *page) {
+    if (page->area != NULL && page->area->advice == VM_ADVICE_SEQUENTIAL)
+        vm_deactivate_behind(spt, page->area, page->va, sequential_window());
+}
+
+/* fault-around 로 함께 올릴 수 있는 페이지인지: 아직 메모리에 없고, 내용을 파일에서
+ * 다시 읽기만 하면 되는 페이지 (처음 접근하는 페이지, 파일 페이지, 버려진 실행 파일 페이지) */
+static bool page_can_fault_around(struct page *page) {
+    if (page->frame != NULL || vm_page_maps_zero(page))
+        return false;
+    if (page->operations->type == VM_UNINIT)
+        return true;
+    if (VM_TYPE(page->operations->type) == VM_FILE)
+        return true;
+    return VM_TYPE(page->operations->type) == VM_ANON && anon_backed_by_file(page);
+}
+
+/* 영역 AREA 의 [START, END) 페이지들이 파일에서 읽는 내용을 readahead 캐시에 읽어 둡니다.
+ * 읽을 내용이 한 페이지보다 짧은 페이지는 영역에서 파일 내용의 마지막 페이지뿐이므로
+ * 범위 전체가 파일에서 이어지는 한 덩어리입니다. */
+static void vm_area_readahead(struct vm_area *area, void *start, void *end, bool sync) {
+    size_t bytes = (size_t) (end - PGSIZE - start) + vm_area_page_read_bytes(area, end - PGSIZE);
+    vm_readahead(area->file, vm_area_page_offset(area, start), bytes, sync);
+}
+
+/* 영역 AREA 의 [START, END) 페이지들의 내용을 파일에서 VM_READAHEAD_BATCH 페이지씩 한 번에
+ * 읽고 올립니다. 페이지는 이미 만들어져 있어야 합니다. MAY_EVICT 가 false 이면 남는 프레임에만
+ * 올리고 남는 프레임보다 많이 읽지 않습니다. 올린 페이지 수를 반환하며, 프레임이 떨어지거나
+ * 읽기에 실패하면 END 전에 멈춥니다. */
+static size_t vm_claim_file_run(struct supplemental_page_table *spt, struct vm_area *area,
+                                void *start, void *end, bool may_evict) {
+    size_t cnt = 0;
+
+    for (void *va = start; va < end; ) {
+        size_t batch = (size_t) (end - va) / PGSIZE;
+
+        if (batch > VM_READAHEAD_BATCH)
+            batch = VM_READAHEAD_BATCH;
+        if (!may_evict) {
+            size_t room = palloc_user_free_cnt();
+            if (spt_rss_room(spt) < room)
+                room = spt_rss_room(spt);
+            if (room == 0)
+                return cnt;
+            if (batch > room)
+                batch = room;
+        }
+
+        void *batch_end = va + batch * PGSIZE;
+        vm_area_readahead(area, va, batch_end, true);
+        for (; va < batch_end; va += PGSIZE) {
+            if (!vm_do_claim_page_frame(spt_find_page(spt, va), may_evict))
+                return cnt;
+            cnt++;
+        }
+    }
+    return cnt;
+}
+
+/* Map the pages around PAGE, inside the same file-backed region, after a
+ * read fault on it. The window is vm_fault_around_pages pages, aligned to
+ * its own size inside the region. Only pages whose data comes from the
+ * file are loaded, and only into free frames: nothing is evicted for a
+ * page that was not asked for. Each run of such consecutive pages is read
+ * from the file in one request. */
+/* 읽기 폴트가 난 PAGE 주변, 같은 영역 안의 페이지들을 함께 올려서 매핑합니다.
+ * 창은 vm_fault_around_pages 페이지이고 영역 안에서 창 크기에 맞춰 정렬됩니다.
+ * 파일에서 내용을 읽어야 하는 페이지만, 남는 프레임에만 올리며 다른 페이지를 쫓아내지 않습니다.
+ * 이어지는 페이지들은 파일에서 한 번에 읽습니다. */
+static void vm_fault_around(struct supplemental_page_table *spt, struct page *page) {
+    struct vm_area *area = page->area;
+    size_t window = vm_fault_around_pages;
+    void *start;
+
+    if (window <= 1 || area == NULL || area->file == NULL || area->advice == VM_ADVICE_RANDOM)
+        return;
+
+    if (area->advice == VM_ADVICE_SEQUENTIAL) {
+        // 순차 접근: 폴트 난 곳부터 앞쪽으로 더 넓게 읽는다 (지나간 페이지는 vm_sequential_fault() 가 처리)
+        window = sequential_window();
+        start = page->va;
+    } else {
+        size_t idx = (page->va - area->start) / PGSIZE;
+        start = area->start + idx / window * window * PGSIZE;
+    }
+    void *end = start + window * PGSIZE < area->end ? start + window * PGSIZE : area->end;
+
+    void *run = NULL; // 파일에서 이어서 읽을 페이지들의 시작
+    for (void *va = start; va < end; va += PGSIZE) {
+        struct page *p = NULL;
+        if (va != page->va && vm_area_page_read_bytes(area, va) > 0)
+            p = spt_lookup_page(spt, va);
+        if (p != NULL && page_can_fault_around(p)) {
+            if (run == NULL)
+                run = va;
+            continue;
+        }
+        if (run != NULL) {
+            size_t cnt = vm_claim_file_run(spt, area, run, va, false);
+            fault_around_cnt += cnt;
+            if (cnt < (size_t) (va - run) / PGSIZE)
+                return; // 남는 프레임이 없다
+            run = NULL;
+        }
+    }
+    if (run != NULL)
+        fault_around_cnt += vm_claim_file_run(spt, area, run, end, false);
 }
 
 /* Return true on success */
@@ -213,23 +1394,41 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED, bool us
         void *rsp = thread_current()->rsp; // syscall에서 커널모드로 전환하기 전에 저장한 user모드의 rsp를 가져옴
     }
 
+    fault_cnt++;
     if (not_present) // 접근한 메모리의 physical page가 존재하지 않은 경우
     {
-        if (addr >= rsp - 8 && rsp - 8 >= USER_STACK - (1<<20) && addr <= USER_STACK ) {
+        if (addr >= rsp - 8 && rsp - 8 >= STACK_LIMIT && addr <= USER_STACK ) {
             vm_stack_growth(addr);
         } 
-        if (addr >= rsp && rsp >= USER_STACK - (1<<20) && addr <= USER_STACK) {
+        if (addr >= rsp && rsp >= STACK_LIMIT && addr <= USER_STACK) {
             vm_stack_growth(addr); 
         }
-        struct page * page = spt_find_page(spt,addr);
+        if (vm_thp && spt_find_page(spt, addr) == NULL && vm_try_huge_fault(spt, addr))
+            return true;
+        struct page * page = spt_lookup_page(spt,addr); // 영역 안의 첫 접근이면 여기서 페이지가 만들어짐
         if (page == NULL){ // 찐 폴트는 걍 죽음
             return false;
         }
-        return vm_do_claim_page(page);
+        vm_sequential_fault(spt, page);
+        if (!write && page_is_zero_fill(page)) // 내용이 0 뿐인 새 페이지를 읽기만 하면 프레임을 주지 않는다
+            return vm_map_zero_page(page);
+        if (!vm_do_claim_page(page))
+            return false;
+        if (!write) // 읽기 폴트면 이웃 페이지도 미리 올려서 다음 폴트를 줄인다
+            vm_fault_around(spt, page);
+        return true;
     }
     /* TODO: Validate the fault */
     /* TODO: Your code goes here */
 
+    // 읽기 전용으로 매핑된 페이지에 쓰기: copy-on-write 인지 확인
+    if (write) {
+        struct page *page = spt_find_page(spt, addr);
+        if (page == NULL || !page->writable)
+            return false;
+        return vm_handle_wp(page);
+    }
+
     return false;
 }
 
@@ -246,7 +1445,7 @@ bool vm_claim_page(void *va UNUSED) {
     /* TODO: Fill this function */
 
     // 해당 page에 프레임을 할당 
-    page = spt_find_page(&thread_current()->spt,va);
+    page = spt_lookup_page(&thread_current()->spt,va);
     if (page == NULL)
     {
         return false;
@@ -255,62 +1454,411 @@ bool vm_claim_page(void *va UNUSED) {
     return vm_do_claim_page(page);
 }
 
+/* Give the current thread its own writable frame for the page at VA
+ * before the kernel stores into it, as a write fault from user mode
+ * would. The kernel runs without CR0.WP, so its writes ignore read-only
+ * PTEs and would otherwise land in a frame shared copy-on-write or in
+ * the zero page. Returns false if VA has no writable page. */
+/* 커널이 VA 의 사용자 페이지에 쓰기 전에, 사용자 모드의 쓰기 폴트처럼 현재 스레드만의
+ * 쓰기 가능한 프레임을 갖게 합니다. 커널은 CR0.WP 없이 돌기 때문에 읽기 전용 PTE 를
+ * 무시하고 공유 중인 프레임이나 zero 페이지에 그대로 써 버립니다.
+ * VA 에 쓰기 가능한 페이지가 없으면 false 를 반환합니다. */
+bool vm_prepare_write(void *va) {
+    struct thread *curr = thread_current();
+    struct page *page = spt_lookup_page(&curr->spt, va);
+
+    if (page == NULL || !page->writable)
+        return false;
+    if (pml4_is_huge(curr->pml4, page->va))
+        return true;
+    uint64_t *pte = pml4e_walk(curr->pml4, (uint64_t) page->va, false);
+    if (pte == NULL || !(*pte & PTE_P)) // 아직 안 올라온 페이지는 커널이 쓸 때 not present 폴트로 올라온다
+        return true;
+    if (is_writable(pte))
+        return true;
+    return vm_handle_wp(page);
+}
+
 /* Claim the PAGE and set up the mmu. */
 static bool vm_do_claim_page(struct page *page) {
-    struct frame *frame = vm_get_frame();
+    return vm_do_claim_page_frame(page, true);
+}
+
+/* vm_do_claim_page() 와 같지만 MAY_EVICT 가 false 이면 빈 프레임이 없을 때
+ * 다른 페이지를 쫓아내지 않고 false 를 반환합니다 (fault-around 용). */
+static bool vm_do_claim_page_frame(struct page *page, bool may_evict) {
+    struct frame key;
+    bool text = page_text_key(page, &key);
+
+    // 같은 프로그램의 다른 프로세스가 이미 올린 코드 페이지면 그 프레임을 함께 쓴다
+    if (text && vm_share_text(page, &key))
+        return true;
+
+    struct frame *frame = may_evict ? vm_get_frame() : vm_get_free_frame();
+    if (frame == NULL)
+        return false;
     struct thread *curr = thread_current();
     /* Set links */
-    frame->page = page;
-    page->frame = frame;
+    vm_map_frame(frame, page, curr->pml4);
 
     /* TODO: Insert page table entry to map page's VA to frame's PA. */
     // 가상주소와 물리주소를 매핑한 정보를 진짜 페이지 테이블인 pml4에 추가
-    if (frame->page != NULL) {
-        if (!pml4_set_page(curr->pml4,page->va,frame->kva,page->writable)) // pml4 present bit 1 
-            return false;
+    if (!pml4_set_page(curr->pml4,page->va,frame_kva(frame),page->writable)) { // pml4 present bit 1 
+        vm_free_frame(page);
+        return false;
     }
  
-    return swap_in(page, frame->kva); // 물리 메모리에 페이지를 올리는 과정 (데이터는 안 올라감)
+    bool ok = swap_in(page, frame_kva(frame)); // 물리 메모리에 페이지를 올리는 과정 (데이터는 안 올라감)
+    if (ok && text)
+        text_register(frame, &key);
+    frame->pinned = false;
+    return ok;
+}
+
+/* Record the access pattern ADVICE for every region that overlaps
+ * [ADDR, ADDR + LENGTH). Returns false if the range is not fully mapped. */
+/* [ADDR, ADDR + LENGTH) 와 겹치는 모든 영역에 접근 패턴 ADVICE 를 기록합니다.
+ * 영역을 쪼개지 않으므로 범위가 영역의 일부만 덮어도 영역 전체에 적용됩니다.
+ * 범위에 매핑되지 않은 페이지가 있으면 false 를 반환합니다. */
+bool vm_advise(void *addr, size_t length, enum vm_advice advice) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+
+    if (!spt_range_is_mapped(spt, addr, length))
+        return false;
+    for (void *va = addr; va < addr + length; ) {
+        struct vm_area *area = spt_find_area(spt, va);
+        area->advice = advice;
+        va = area->end;
+    }
+    return true;
+}
+
+/* Prefetch the pages of [ADDR, ADDR + LENGTH) ahead of use. Data that
+ * comes from a file is queued for the readahead thread and loaded from
+ * memory on the first access, so this does not wait for it. Anonymous
+ * pages that were swapped out are swapped in now, into free frames only;
+ * this part blocks on the swap device. Returns false if the range is not
+ * fully mapped. */
+/* [ADDR, ADDR + LENGTH) 의 페이지를 미리 준비합니다. 파일에서 읽을 내용은 readahead 스레드에
+ * 맡기고 기다리지 않으며, 첫 접근에서 디스크 대신 미리 읽은 내용으로 올라갑니다.
+ * 스왑된 anon 페이지는 지금 남는 프레임에 올리므로 이 부분은 스왑 디스크를 기다립니다.
+ * 내용이 0 뿐인 새 페이지는 어차피 첫 접근에서 복사 없이 만들어지므로 건너뜁니다. */
+bool vm_willneed(void *addr, size_t length) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+    void *end = addr + length;
+
+    if (!spt_range_is_mapped(spt, addr, length))
+        return false;
+    for (void *va = addr; va < end; ) {
+        struct vm_area *area = spt_find_area(spt, va);
+        void *area_end = area->end < end ? area->end : end;
+        void *run = NULL; // 파일에서 이어서 읽을 페이지들의 시작
+
+        for (; va < area_end; va += PGSIZE) {
+            struct page *page = spt_find_page(spt, va);
+            if (vm_area_page_read_bytes(area, va) > 0 && (page == NULL || page_can_fault_around(page))) {
+                if (run == NULL)
+                    run = va;
+                willneed_cnt++;
+                continue;
+            }
+            if (run != NULL) {
+                vm_area_readahead(area, run, va, false);
+                run = NULL;
+            }
+            if (page != NULL && page->frame == NULL && VM_TYPE(page->operations->type) == VM_ANON
+                && page->anon.swap_idx != -1 && vm_do_claim_page_frame(page, false))
+                willneed_cnt++;
+        }
+        if (run != NULL)
+            vm_area_readahead(area, run, area_end, false);
+    }
+    return true;
+}
+
+/* Load and map every page of [ADDR, ADDR + LENGTH) right away, evicting
+ * other pages if needed, so that later accesses to the range take no page
+ * faults. Consecutive pages whose data comes from a file are read in
+ * batches of VM_READAHEAD_BATCH pages, one request each. Used for mmap()
+ * with MAP_POPULATE. Returns false, with part of the range possibly
+ * loaded, if a page cannot be loaded. */
+/* [ADDR, ADDR + LENGTH) 의 모든 페이지를 지금 올려서 PTE 까지 설치합니다.
+ * 필요하면 다른 페이지를 쫓아냅니다. 이후 이 범위에 접근할 때는 폴트가 나지 않습니다.
+ * 파일에서 이어서 읽는 페이지들은 VM_READAHEAD_BATCH 페이지씩 한 번에 읽습니다.
+ * MAP_POPULATE 를 준 mmap() 에서 쓰며, 올리지 못한 페이지가 있으면 false 를 반환합니다. */
+bool vm_populate(void *addr, size_t length) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+    void *end = addr + length;
+
+    for (void *va = addr; va < end; ) {
+        struct vm_area *area = spt_find_area(spt, va);
+        if (area == NULL)
+            return false;
+        void *area_end = area->end < end ? area->end : end;
+        void *run = NULL; // 파일에서 이어서 읽을 페이지들의 시작
+
+        for (; va < area_end; va += PGSIZE) {
+            struct page *page = spt_lookup_page(spt, va);
+            if (page == NULL)
+                return false;
+            if (vm_area_page_read_bytes(area, va) > 0 && page_can_fault_around(page)) {
+                if (run == NULL)
+                    run = va;
+                continue;
+            }
+            if (run != NULL) {
+                size_t cnt = vm_claim_file_run(spt, area, run, va, true);
+                populate_cnt += cnt;
+                if (cnt < (size_t) (va - run) / PGSIZE)
+                    return false;
+                run = NULL;
+            }
+            if (page->frame != NULL)
+                continue;
+            if (!vm_do_claim_page(page))
+                return false;
+            populate_cnt++;
+        }
+        if (run != NULL) {
+            size_t cnt = vm_claim_file_run(spt, area, run, area_end, true);
+            populate_cnt += cnt;
+            if (cnt < (size_t) (area_end - run) / PGSIZE)
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Drop the pages of [ADDR, ADDR + LENGTH), freeing their frames and swap
+ * slots at once. Dirty file-backed pages are written back first. The next
+ * access recreates each page from its region, as on first touch. Returns
+ * false if the range is not fully mapped. */
+/* [ADDR, ADDR + LENGTH) 의 페이지를 버리고 프레임과 스왑 슬롯을 바로 반납합니다.
+ * 수정된 파일 페이지는 먼저 파일에 씁니다. 다음 접근에서는 처음 접근할 때처럼
+ * 영역으로부터 페이지를 다시 만듭니다 (anon 은 0 또는 실행 파일의 내용). */
+bool vm_dontneed(void *addr, size_t length) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+
+    if (!spt_range_is_mapped(spt, addr, length))
+        return false;
+    void *end = addr + length;
+    struct tlb_batch batch;
+    tlb_batch_begin(&batch, thread_current()->pml4);
+    // 영역마다 이미 만들어진 페이지만 본다. 아직 만들어지지 않은 페이지는 버릴 것도 없다.
+    for (void *va = addr; va < end; ) {
+        struct vm_area *area = spt_find_area(spt, va);
+        for (struct list_elem *e = list_begin(&area->pages); e != list_end(&area->pages); ) {
+            struct page *page = list_entry(e, struct page, area_elem);
+            e = list_next(e);
+            if (page->va < addr || page->va >= end)
+                continue;
+            spt_remove_page(spt, page);
+            dontneed_cnt++;
+        }
+        va = area->end;
+    }
+    tlb_batch_end(&batch);
+    return true;
+}
+
+/* Move every page on PAGES, the page list of a region of SPT, by DELTA
+ * bytes. Resident pages keep their frames: only the page table entries and
+ * the page descriptors change. SPT must be the current thread's and the
+ * destination range must be empty. Returns false, with nothing moved, if
+ * memory for page tables runs out. */
+/* 영역의 페이지 리스트 PAGES 에 있는 모든 페이지를 DELTA 바이트만큼 옮깁니다.
+ * 메모리에 있는 페이지도 프레임은 그대로 두고 PTE 와 struct page 만 옮깁니다.
+ * SPT 는 현재 스레드의 것이어야 하고 옮겨 갈 범위는 비어 있어야 합니다.
+ * 페이지 테이블을 만들 메모리가 없으면 아무것도 옮기지 않고 false 를 반환합니다. */
+bool spt_move_pages(struct supplemental_page_table *spt, struct list *pages, ptrdiff_t delta) {
+    uint64_t *pml4 = thread_current()->pml4;
+    struct list_elem *e;
+
+    // 도중에 실패하지 않도록 PTE 가 있는 (zero 페이지에 매핑된 것도 포함) 모든 페이지의
+    // 옮겨 갈 자리에 페이지 테이블을 먼저 만들어 둔다. PTE 가 없는 페이지는
+    // pml4_move_page() 가 옮겨 갈 자리를 건드리지 않는다.
+    for (e = list_begin(pages); e != list_end(pages); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, area_elem);
+        if (pml4_get_page(pml4, page->va) != NULL
+            && pml4e_walk(pml4, (uint64_t) (page->va + delta), 1) == NULL)
+            return false;
+    }
+
+    // 쫓아내는 쪽은 frame_lock 을 잡고 page->va 로 PTE 를 찾으므로 옮기는 동안 막아 둔다
+    lock_acquire(&frame_lock);
+    for (e = list_begin(pages); e != list_end(pages); e = list_next(e)) {
+        struct page *page = list_entry(e, struct page, area_elem);
+
+        hash_delete(&spt->spt_hash, &page->spt_entry);
+        if (!pml4_move_page(pml4, page->va, page->va + delta))
+            NOT_REACHED();
+        page->va += delta;
+        hash_insert(&spt->spt_hash, &page->spt_entry);
+    }
+    lock_release(&frame_lock);
+    memset(spt->cache, 0, sizeof spt->cache);
+    return true;
+}
+
+/* Write the modified file-backed pages of [ADDR, ADDR + LENGTH) back to
+ * their files. The pages stay mapped and are clean afterwards. If SYNC,
+ * wait until the data has reached the disk. Returns false if the range is
+ * not fully mapped. */
+/* [ADDR, ADDR + LENGTH) 에서 수정된 파일 페이지를 파일에 씁니다. 페이지는 매핑된 채로
+ * 남고 dirty 비트만 지워집니다. SYNC 이면 디스크에 기록될 때까지 기다립니다. */
+bool vm_msync(void *addr, size_t length, bool sync) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+
+    if (!spt_range_is_mapped(spt, addr, length))
+        return false;
+    for (void *va = addr; va < addr + length; ) {
+        struct vm_area *area = spt_find_area(spt, va);
+        void *end = area->end < addr + length ? area->end : addr + length;
+
+        if (area->type != VM_FILE) {
+            va = end;
+            continue;
+        }
+        for (; va < end; va += PGSIZE) {
+            struct page *page = spt_find_page(spt, va);
+            if (page == NULL) // 만들어지지 않은 페이지는 수정된 적도 없다
+                continue;
+
+            // frame_lock 은 프레임을 고정하고 dirty 비트를 지울 때만 잡는다.
+            // 큐에 넣거나 파일에 쓰는 동안에는 놓아서 다른 폴트가 기다리지 않게 한다.
+            lock_acquire(&frame_lock);
+            struct frame *frame = page->frame;
+            bool dirty = frame != NULL && !frame->pinned && page->operations->type == VM_FILE
+                         && vm_frame_is_dirty(frame);
+            if (dirty) {
+                frame->pinned = true; // 기록하는 동안 쫓겨나지 않도록 고정
+                // dirty 비트를 먼저 지우므로 복사한 뒤에 일어난 쓰기는 다음 기록에서 빠지지 않는다
+                vm_frame_set_dirty(frame, false);
+            }
+            lock_release(&frame_lock);
+            if (!dirty)
+                continue;
+
+            file_backed_writeback(page);
+            msync_cnt++;
+            lock_acquire(&frame_lock);
+            frame->pinned = false;
+            lock_release(&frame_lock);
+        }
+        if (sync)
+            vm_writeback_wait(file_get_inode(area->file));
+    }
+    return true;
+}
+
+/* Limit the current process's resident set to PAGES pages, 0 meaning no
+ * limit. Pages over the new limit are evicted right away. Returns false
+ * if PAGES is too small to run in. */
+/* 현재 프로세스의 RSS 상한을 PAGES 페이지로 정합니다. 0 이면 제한을 없앱니다.
+ * 이미 상한보다 많이 올라와 있으면 그만큼 바로 자기 페이지를 내보냅니다.
+ * PAGES 가 너무 작아 실행할 수 없으면 false 를 반환합니다. */
+bool vm_set_rss_limit(size_t pages) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+
+    if (pages != 0 && pages < RSS_LIMIT_MIN)
+        return false;
+    lock_acquire(&frame_lock);
+    spt->rss_limit = pages;
+    while (spt->rss_limit != 0 && spt->rss > spt->rss_limit) {
+        struct frame *frame = vm_evict_frame(spt);
+        if (frame == NULL) // 모두 고정되어 있거나 스왑이 가득 찼다
+            break;
+        vm_release_frame_locked(frame);
+        rss_reclaim_cnt++;
+    }
+    lock_release(&frame_lock);
+    return true;
 }
 
 /* Initialize new supplemental page table */
 void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED) {
     
     hash_init(&spt->spt_hash, page_hash, page_less, NULL);
+    memset(spt->cache, 0, sizeof spt->cache);
+    spt->areas = NULL;
+    spt->area_cnt = spt->area_cap = 0;
+    spt->rss = 0;
+    spt->rss_limit = vm_rss_limit;
 }
 
 /* Copy supplemental page table from src to dst */
+/* 부모(src)의 보조 페이지 테이블을 자식(dst)에 복사합니다. 자식 스레드에서 호출됩니다.
+ * 메모리에 올라와 있는 페이지는 복사하지 않고 프레임을 읽기 전용으로 공유하고 (copy-on-write),
+ * 실제 복사는 처음 쓰기가 일어날 때 vm_handle_wp() 에서 합니다. */
 bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED, struct supplemental_page_table *src UNUSED) {
 
     // src 의 보조 페이지 테이블을 반복하면서, 목적지 보조 테이블의 엔트리의 정확한 복사본을 만들기
-
+    // struct thread 는 자기 페이지의 맨 앞에 있으므로 src 로부터 부모 스레드를 구할 수 있다
+    struct thread *parent = (struct thread *) pg_round_down(src);
     struct hash_iterator i; 
 
+    // RSS 상한은 자식에게 물려준다
+    dst->rss_limit = src->rss_limit;
+
+    // 영역은 통째로 복사하고, 아직 만들어지지 않은 페이지는 자식이 접근할 때 만든다
+    if (!spt_copy_areas(dst, src)) {
+        return false;
+    }
+
 	hash_first(&i, &src->spt_hash);
 	while (hash_next(&i))
 	{
         struct page *page = hash_entry(hash_cur(&i), struct page, spt_entry); // 해당 페이지들을 가져와서, 목적지 보조 테이블의 엔트리에 복사본 삽입 ? 
 
-        // 매핑됐냐 안 됐냐로 판단
         // 부모가 매핑이 안 됐으면, 즉 uninit이면 그 페이지를 그대로 spt에 복사해준다.
-        // 부모가 매핑 됐으면 즉, uninit 이 아니면 페이지를 할당해주고, 즉시 매핑
         enum vm_type type = page_get_type(page);
+        struct vm_area *area = page->area != NULL ? spt_find_area(dst, page->va) : NULL;
+        if (page->operations->type == VM_TYPE(VM_UNINIT) && area != NULL) // 영역 안의 uninit 페이지는 영역만으로 다시 만들 수 있다
+            continue;
         if (page->operations->type == VM_TYPE(VM_UNINIT)) // 부모가 매핑이 안 됐으면, 즉 uninit이면 그 페이지를 그대로 spt에 복사해준다.
          {  
             bool ok = vm_alloc_page_with_initializer(type, page->va,page->writable, page->uninit.init, page->uninit.aux); // 페이지 생성후 보조 페이지 테이블에 넣기까지 성공
             if (!ok)
                 return false;
-            
-        } else 
-        {   
-            bool ok = vm_alloc_page(type, page->va, page->writable);
+            continue;
+        }
+
+        // 초기화된 페이지는 같은 타입의 페이지로 그대로 복제한다 (anon 의 swap slot 은 공유하지 않음)
+        struct page *child_page = (struct page *)malloc(sizeof(struct page));
+        if (child_page == NULL)
+            return false;
+        memcpy(child_page, page, sizeof(struct page));
+        child_page->frame = NULL;
+        child_page->area = area;
+        if (type == VM_ANON) {
+            child_page->anon.swap_idx = -1;
+            child_page->anon.readahead = false;
+        }
+        if (!spt_insert_page(dst, child_page)) {
+            free(child_page);
+            return false;
+        }
+        if (area != NULL)
+            list_push_back(&area->pages, &child_page->area_elem);
+
+        // 메모리에 있으면 프레임 공유
+        if (vm_share_frame(parent, child_page, page))
+            continue;
+
+        // 스왑 아웃된 anon 페이지는 스왑 슬롯의 내용을 새 프레임으로 읽어온다.
+        // 파일 페이지와 버려진 실행 파일 페이지는 처음 접근할 때 파일에서 다시 읽으면 된다.
+        if (type == VM_ANON && page->anon.swap_idx != -1) {
+            struct frame *frame = vm_get_frame();
+            anon_swap_copy(page, frame_kva(frame));
+            vm_map_frame(frame, child_page, thread_current()->pml4);
+            bool ok = pml4_set_page(thread_current()->pml4, child_page->va, frame_kva(frame), child_page->writable);
+            frame->pinned = false;
             if (!ok)
                 return false;
-            struct page *child_page = spt_find_page(dst, page->va);
-            vm_do_claim_page(child_page);
-            memcpy(child_page->frame->kva, page->frame->kva, PGSIZE);
+            fork_copy_cnt++;
         }
 	}
+    fork_cnt++;
     return true;
 }
 
@@ -324,7 +1872,16 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED) {
     // 보조 페이지에 의해 유지되던 모든 자원 free 
     // process_exit 할 때 호출 , 페이지 엔트리 반복하면서 페이지에 destroy 
     
+    // 영역 안의 페이지는 영역과 함께 정리되고, 남은 스택 페이지를 해시에서 지운다.
+    // 페이지마다 TLB 항목을 버리지 않고 끝에서 주소 공간 전체를 한 번에 비운다
+    struct tlb_batch batch;
+    tlb_batch_begin(&batch, thread_current()->pml4);
+    // 2 MB 매핑은 4 KB 로 쪼개지 않고 PDE 째로 지운다. 프레임은 페이지마다 아래에서 해제된다.
+    pml4_clear_huge_pages(thread_current()->pml4);
+    spt_kill_areas(spt);
+    memset(spt->cache, 0, sizeof spt->cache);
     hash_clear(spt, clear_action_func);
+    tlb_batch_end(&batch);
 
 }
 